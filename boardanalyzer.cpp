@@ -0,0 +1,55 @@
+#include "boardanalyzer.h"
+#include "boardengine.h"
+#include <QtConcurrent>
+
+BoardAnalyzer::BoardAnalyzer(QObject *parent)
+    : QObject(parent), latestRevision(std::make_shared<std::atomic<quint64>>(0))
+{
+    hintWatcher = new QFutureWatcher<AnalysisResult>(this);
+    connect(hintWatcher, &QFutureWatcher<AnalysisResult>::finished, this, &BoardAnalyzer::onHintFinished);
+    stuckWatcher = new QFutureWatcher<AnalysisResult>(this);
+    connect(stuckWatcher, &QFutureWatcher<AnalysisResult>::finished, this, &BoardAnalyzer::onStuckFinished);
+}
+
+BoardAnalyzer::~BoardAnalyzer() {
+    // 让仍在运行的分析尽快退出；工作线程只持有快照和共享计数，不访问this
+    latestRevision->store(~quint64(0));
+}
+
+void BoardAnalyzer::invalidate(quint64 revision) {
+    latestRevision->store(revision);
+}
+
+QFuture<AnalysisResult> BoardAnalyzer::runAnalysis(const BoardEngine& snapshot, quint64 revision) {
+    latestRevision->store(revision);
+    // 快照按值捕获：引擎的图案和索引隐式共享，这里只增加引用计数，棋盘之后的修改会自行分离。
+    // 工作线程直接用快照的位图和类型索引查找，不展开成二维数组
+    std::shared_ptr<std::atomic<quint64>> latest = latestRevision;
+    return QtConcurrent::run([snapshot, revision, latest]() {
+        AnalysisResult r{revision, false, false, QPoint(), QPoint()};
+        auto cancelled = [&]() { return latest->load(std::memory_order_relaxed) != revision; };
+        r.found = snapshot.findHint(r.a, r.b, cancelled);
+        r.cancelled = cancelled();
+        return r;
+    });
+}
+
+void BoardAnalyzer::requestHint(const BoardEngine& snapshot, quint64 revision) {
+    hintWatcher->setFuture(runAnalysis(snapshot, revision));
+}
+
+void BoardAnalyzer::requestStuckCheck(const BoardEngine& snapshot, quint64 revision) {
+    stuckWatcher->setFuture(runAnalysis(snapshot, revision));
+}
+
+void BoardAnalyzer::onHintFinished() {
+    AnalysisResult r = hintWatcher->result();
+    if (r.cancelled || r.revision != latestRevision->load()) return;
+    emit hintReady(r.revision, r.found, r.a, r.b);
+}
+
+void BoardAnalyzer::onStuckFinished() {
+    AnalysisResult r = stuckWatcher->result();
+    if (r.cancelled || r.revision != latestRevision->load()) return;
+    emit stuckChecked(r.revision, !r.found);
+}
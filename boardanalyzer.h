@@ -0,0 +1,50 @@
+#ifndef BOARDANALYZER_H
+#define BOARDANALYZER_H
+#include <QObject>
+#include <QVector>
+#include <QPoint>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <atomic>
+#include <memory>
+
+class BoardEngine;
+
+// 一次后台分析的结果
+struct AnalysisResult {
+    quint64 revision;  // 分析所基于的棋盘版本
+    bool cancelled;    // 棋盘在分析过程中已变化
+    bool found;        // 是否找到可消除的一对
+    QPoint a;
+    QPoint b;
+};
+
+// 在线程池上对棋盘快照做提示/僵局分析，结果通过信号回到GUI线程。
+// 棋盘版本变化后，旧快照上的分析会尽早中止，其结果也会被丢弃。
+class BoardAnalyzer : public QObject {
+    Q_OBJECT
+public:
+    explicit BoardAnalyzer(QObject *parent = nullptr);
+    ~BoardAnalyzer();
+    // snapshot应来自BoardEngine::snapshot()，与棋盘共享存储，传入时不复制
+    void requestHint(const BoardEngine& snapshot, quint64 revision);
+    void requestStuckCheck(const BoardEngine& snapshot, quint64 revision);
+    void invalidate(quint64 revision); // 棋盘已变化，取消旧版本上的分析
+
+signals:
+    void hintReady(quint64 revision, bool found, const QPoint& a, const QPoint& b);
+    void stuckChecked(quint64 revision, bool stuck);
+
+private slots:
+    void onHintFinished();
+    void onStuckFinished();
+
+private:
+    QFutureWatcher<AnalysisResult> *hintWatcher;
+    QFutureWatcher<AnalysisResult> *stuckWatcher;
+    std::shared_ptr<std::atomic<quint64>> latestRevision; // 与工作线程共享
+
+    QFuture<AnalysisResult> runAnalysis(const BoardEngine& snapshot, quint64 revision);
+};
+
+#endif
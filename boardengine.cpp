@@ -0,0 +1,869 @@
+#include "boardengine.h"
+#include <algorithm>
+#include <numeric>
+
+BoardEngine::BoardEngine(int r, int c)
+    : rows(r), cols(c), tiles(r * c, 0), tileBytes(1), shiftRule(SHIFT_NONE), remaining(0), maxHistory(0)
+{
+    rebuildIndex();
+}
+
+void BoardEngine::setMap(const QVector<QVector<int>>& layout) {
+    rows = layout.size();
+    cols = rows > 0 ? layout[0].size() : 0;
+    int maxValue = 0;
+    for (const QVector<int>& row : layout) {
+        for (int v : row) maxValue = qMax(maxValue, v);
+    }
+    tileBytes = maxValue > 255 ? 2 : 1;
+    tiles = QByteArray(rows * cols * tileBytes, 0);
+    for(int i = 0; i < rows; i++) {
+        for(int j = 0; j < cols; j++) storeTile(i * cols + j, layout[i][j]);
+    }
+    rebuildIndex();
+    clearHistory();
+}
+
+bool BoardEngine::setPacked(int r, int c, const QByteArray& packed, int bytesPerTile) {
+    if ((bytesPerTile != 1 && bytesPerTile != 2) || packed.size() != r * c * bytesPerTile) return false;
+    rows = r;
+    cols = c;
+    tiles = packed;
+    tileBytes = bytesPerTile;
+    rebuildIndex();
+    clearHistory();
+    return true;
+}
+
+QByteArray BoardEngine::tilesLittleEndian(const QByteArray& packed, int bytesPerTile) {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    Q_UNUSED(bytesPerTile);
+    return packed;
+#else
+    if (bytesPerTile == 1) return packed;
+    QByteArray swapped = packed;
+    for(int k = 0; k + 1 < swapped.size(); k += 2) std::swap(swapped[k], swapped[k + 1]);
+    return swapped;
+#endif
+}
+
+BoardEngine BoardEngine::snapshot() const {
+    BoardEngine copy(*this);
+    copy.clearHistory();
+    return copy;
+}
+
+QVector<QVector<int>> BoardEngine::cells() const {
+    QVector<QVector<int>> layout(rows, QVector<int>(cols, 0));
+    for(int i = 0; i < rows; i++) {
+        for(int j = 0; j < cols; j++) layout[i][j] = at(i, j);
+    }
+    return layout;
+}
+
+void BoardEngine::storeTile(int k, int value) {
+    if (tileBytes == 1) {
+        tiles[k] = char(value);
+    } else {
+        reinterpret_cast<quint16*>(tiles.data())[k] = quint16(value);
+    }
+}
+
+void BoardEngine::widenTiles() {
+    QByteArray wide(rows * cols * 2, 0);
+    quint16* out = reinterpret_cast<quint16*>(wide.data());
+    for(int k = 0; k < rows * cols; k++) out[k] = quint8(tiles[k]);
+    tiles = wide;
+    tileBytes = 2;
+}
+
+QVector<QPoint> BoardEngine::positionsOf(int value) const {
+    QVector<QPoint> result;
+    if (value <= 0 || value >= typePositions.size()) return result;
+    for (quint32 k : typePositions[value]) result.append(QPoint(int(k) / cols, int(k) % cols));
+    return result;
+}
+
+BoardEngine::MemoryUsage BoardEngine::memoryUsage() const {
+    MemoryUsage usage;
+    usage.tiles = tiles.capacity();
+    usage.occupancy = (rowBits.capacity() + colBits.capacity()) * qint64(sizeof(quint64));
+    usage.typeIndex = typePositions.capacity() * qint64(sizeof(QVector<quint32>));
+    for (const QVector<quint32>& list : typePositions) usage.typeIndex += list.capacity() * qint64(sizeof(quint32));
+    return usage;
+}
+
+QString BoardEngine::memoryReport() const {
+    MemoryUsage usage = memoryUsage();
+    return QString("Board %1x%2 (%3 bit tiles): %4 KB total, tiles %5 KB, occupancy %6 KB, type index %7 KB")
+        .arg(rows).arg(cols).arg(tileBytes * 8).arg(usage.total() / 1024.0, 0, 'f', 1)
+        .arg(usage.tiles / 1024.0, 0, 'f', 1).arg(usage.occupancy / 1024.0, 0, 'f', 1)
+        .arg(usage.typeIndex / 1024.0, 0, 'f', 1);
+}
+
+void BoardEngine::rebuildIndex() {
+    rowWords = (cols + 63) / 64;
+    colWords = (rows + 63) / 64;
+    rowBits = QVector<quint64>(rows * rowWords, 0);
+    colBits = QVector<quint64>(cols * colWords, 0);
+    typePositions.clear();
+    remaining = 0;
+    for(int i = 0; i < rows; i++) {
+        for(int j = 0; j < cols; j++) {
+            int v = at(i, j);
+            if(v != 0) indexAdd(QPoint(i, j), v);
+        }
+    }
+}
+
+void BoardEngine::indexAdd(const QPoint& p, int value) {
+    int r = p.x(), c = p.y();
+    rowBits[r * rowWords + (c >> 6)] |= quint64(1) << (c & 63);
+    colBits[c * colWords + (r >> 6)] |= quint64(1) << (r & 63);
+    if (value >= typePositions.size()) typePositions.resize(value + 1);
+    typePositions[value].append(quint32(r * cols + c));
+    remaining++;
+}
+
+void BoardEngine::indexRemove(const QPoint& p, int value) {
+    int r = p.x(), c = p.y();
+    rowBits[r * rowWords + (c >> 6)] &= ~(quint64(1) << (c & 63));
+    colBits[c * colWords + (r >> 6)] &= ~(quint64(1) << (r & 63));
+    QVector<quint32>& list = typePositions[value];
+    int idx = list.indexOf(quint32(r * cols + c));
+    if (idx >= 0) {
+        list[idx] = list.last(); // 顺序无关，与末尾交换后删除
+        list.removeLast();
+    }
+    remaining--;
+}
+
+void BoardEngine::setCell(const QPoint& p, int value) {
+    int old = at(p);
+    if (old == value) return;
+    if (old != 0) indexRemove(p, old);
+    if (value > 255 && tileBytes == 1) widenTiles();
+    storeTile(p.x() * cols + p.y(), value);
+    if (value != 0) indexAdd(p, value);
+}
+
+QVector<TileMove> BoardEngine::removePair(const QPoint& a, const QPoint& b) {
+    MoveRecord record{false, quint32(a.x() * cols + a.y()), quint32(b.x() * cols + b.y()), at(a), {}, {}};
+    QVector<TileMove> moves;
+    setCell(a, 0);
+    setCell(b, 0);
+    if (shiftRule != SHIFT_NONE) {
+        // 只整理两个空位所在的行/列；第二次整理若与第一次同线则不会产生移动
+        applyShift(a, moves);
+        applyShift(b, moves);
+    }
+    record.shifts = moves;
+    pushHistory(record);
+    return moves;
+}
+
+void BoardEngine::pushHistory(const MoveRecord& record) {
+    redoStack.clear();
+    if (maxHistory <= 0) return;
+    if (undoStack.size() >= maxHistory) undoStack.removeFirst();
+    undoStack.append(record);
+}
+
+void BoardEngine::setHistoryLimit(int limit) {
+    maxHistory = qMax(0, limit);
+    while (undoStack.size() > maxHistory) undoStack.removeFirst();
+    if (maxHistory == 0) redoStack.clear();
+}
+
+void BoardEngine::clearHistory() {
+    undoStack.clear();
+    redoStack.clear();
+}
+
+QVector<QPoint> BoardEngine::occupiedCells() const {
+    QVector<QPoint> positions;
+    positions.reserve(remaining);
+    for(int i = 0; i < rows; i++) {
+        for(int j = 0; j < cols; j++) {
+            if(at(i, j) != 0) positions.append(QPoint(i, j));
+        }
+    }
+    return positions;
+}
+
+// 正向：第k个格子取第permutation[k]个格子的图案；逆向把图案放回原处
+void BoardEngine::applyPermutation(const QVector<QPoint>& positions, const QVector<int>& permutation, bool inverse) {
+    QVector<int> values(positions.size());
+    for(int k = 0; k < positions.size(); k++) values[k] = at(positions[k]);
+    for(int k = 0; k < positions.size(); k++) {
+        if (inverse) setCell(positions[permutation[k]], values[k]);
+        else setCell(positions[k], values[permutation[k]]);
+    }
+}
+
+// 按记录逆序还原：先把规则移动过的图块移回，再放回消除的两块。
+// 每步都经过setCell，位图、类型索引和剩余数随之恢复，不重建
+bool BoardEngine::undo(QVector<QPoint>* changed, MoveRecord* record) {
+    if (undoStack.isEmpty()) return false;
+    MoveRecord rec = undoStack.takeLast();
+    if (rec.shuffle) {
+        // 重排不改变哪些格子有图块，非空格子的行优先顺序与重排时相同
+        QVector<QPoint> positions = occupiedCells();
+        applyPermutation(positions, rec.permutation, true);
+        if (changed) *changed = positions;
+    } else {
+        QPoint a(int(rec.a) / cols, int(rec.a) % cols), b(int(rec.b) / cols, int(rec.b) % cols);
+        for(int k = rec.shifts.size() - 1; k >= 0; k--) {
+            const TileMove& m = rec.shifts[k];
+            setCell(m.to, 0);
+            setCell(m.from, m.value);
+        }
+        setCell(a, rec.value);
+        setCell(b, rec.value);
+        if (changed) {
+            changed->clear();
+            changed->append(a);
+            changed->append(b);
+            for (const TileMove& m : rec.shifts) {
+                changed->append(m.from);
+                changed->append(m.to);
+            }
+        }
+    }
+    if (record) *record = rec;
+    redoStack.append(rec);
+    return true;
+}
+
+// 重做直接回放记录下的移动，不重新计算移动规则，也不再消耗随机数
+bool BoardEngine::redo(QVector<QPoint>* changed, MoveRecord* record) {
+    if (redoStack.isEmpty()) return false;
+    MoveRecord rec = redoStack.takeLast();
+    if (rec.shuffle) {
+        QVector<QPoint> positions = occupiedCells();
+        applyPermutation(positions, rec.permutation, false);
+        if (changed) *changed = positions;
+    } else {
+        QPoint a(int(rec.a) / cols, int(rec.a) % cols), b(int(rec.b) / cols, int(rec.b) % cols);
+        setCell(a, 0);
+        setCell(b, 0);
+        for (const TileMove& m : rec.shifts) {
+            setCell(m.from, 0);
+            setCell(m.to, m.value);
+        }
+        if (changed) {
+            changed->clear();
+            changed->append(a);
+            changed->append(b);
+            for (const TileMove& m : rec.shifts) {
+                changed->append(m.from);
+                changed->append(m.to);
+            }
+        }
+    }
+    if (record) *record = rec;
+    undoStack.append(rec);
+    return true;
+}
+
+void BoardEngine::applyShift(const QPoint& freed, QVector<TileMove>& moves) {
+    QVector<QPoint> line;
+    switch(shiftRule) {
+        case SHIFT_NONE:
+            return;
+        case SHIFT_DOWN:
+            for(int r = rows - 1; r >= 0; r--) line.append(QPoint(r, freed.y()));
+            break;
+        case SHIFT_LEFT:
+            for(int c = 0; c < cols; c++) line.append(QPoint(freed.x(), c));
+            break;
+        case SHIFT_CENTER: {
+            // 左半边向右靠拢，右半边向左靠拢
+            int mid = cols / 2;
+            if (freed.y() < mid) {
+                for(int c = mid - 1; c >= 0; c--) line.append(QPoint(freed.x(), c));
+            } else {
+                for(int c = mid; c < cols; c++) line.append(QPoint(freed.x(), c));
+            }
+            break;
+        }
+    }
+    compactLine(line, moves);
+}
+
+// 把line上的图块按原有顺序压向line[0]一端
+void BoardEngine::compactLine(const QVector<QPoint>& line, QVector<TileMove>& moves) {
+    int write = 0;
+    for(int k = 0; k < line.size(); k++) {
+        const QPoint& p = line[k];
+        int v = at(p);
+        if (v == 0) continue;
+        if (k != write) {
+            const QPoint& target = line[write];
+            setCell(p, 0);
+            setCell(target, v);
+            moves.append({p, target, v});
+        }
+        write++;
+    }
+}
+
+// 检查words中[from, to)范围内的位是否全为0
+bool BoardEngine::bitsClear(const quint64* words, int from, int to) {
+    if (from >= to) return true;
+    int fw = from >> 6;
+    int lw = (to - 1) >> 6;
+    quint64 fmask = ~quint64(0) << (from & 63);
+    quint64 lmask = ~quint64(0) >> (63 - ((to - 1) & 63));
+    if (fw == lw) return (words[fw] & fmask & lmask) == 0;
+    if (words[fw] & fmask) return false;
+    for(int w = fw + 1; w < lw; w++) {
+        if (words[w]) return false;
+    }
+    return (words[lw] & lmask) == 0;
+}
+
+bool BoardEngine::lineClearRow(int r, int c1, int c2) const {
+    int minC = qMin(c1, c2);
+    int maxC = qMax(c1, c2);
+    return bitsClear(rowBits.constData() + r * rowWords, minC + 1, maxC);
+}
+
+bool BoardEngine::lineClearCol(int c, int r1, int r2) const {
+    int minR = qMin(r1, r2);
+    int maxR = qMax(r1, r2);
+    return bitsClear(colBits.constData() + c * colWords, minR + 1, maxR);
+}
+
+// 快速验证可解性（简化版）
+QVector<QVector<int>> BoardEngine::generateLayout(int rows, int cols, Difficulty difficulty, GameRng& rng,
+                                                  int *verifyRetries, int typeCount) {
+    QVector<QVector<int>> map(rows, QVector<int>(cols, 0));
+    
+    int totalCells = rows * cols;
+    int pairCount = totalCells / 2;
+    if (typeCount <= 0) typeCount = typeCountFor(rows, cols);
+    
+    QVector<int> values;
+    for(int i = 0; i < pairCount; i++) {
+        int v = (i % typeCount) + 1;
+        values.append(v);
+        values.append(v);
+    }
+    
+    // 根据难度生成不同布局
+    switch(difficulty) {
+        case BEGINNER: {
+            // 入门级：尽量相邻配对，保证直连多
+            // 每对图片都相邻放置，确保可以直接连接
+            int pairIdx = 0;
+            for(int i = 0; i < rows; i++) {
+                for(int j = 0; j < cols; j += 2) {
+                    if (j + 1 < cols && pairIdx < pairCount) {
+                        int val = (pairIdx % typeCount) + 1;
+                        map[i][j] = val;
+                        map[i][j+1] = val; // 相邻配对，可以直连
+                        pairIdx++;
+                    }
+                }
+            }
+            // 如果cols是奇数，处理最后一列
+            if(cols % 2 == 1 && pairIdx < pairCount) {
+                // 最后一列与下一行配对
+                for(int i = 0; i < rows - 1 && pairIdx < pairCount; i += 2) {
+                    int val = (pairIdx % typeCount) + 1;
+                    map[i][cols-1] = val;
+                    map[i+1][cols-1] = val; // 同一列相邻，可以直连
+                    pairIdx++;
+                }
+            }
+            break;
+        }
+        
+        case PRIMARY: {
+            // 初级：生成较多一拐的配对
+            // 策略：让配对在同一行或同一列，但不相邻，这样可以一拐连接
+            std::shuffle(values.begin(), values.end(), rng);
+            
+            int pairIdx = 0;
+            // 尽量在同一行放置配对，但不相邻
+            for(int i = 0; i < rows; i++) {
+                QVector<int> colIndices;
+                for(int j = 0; j < cols; j++) {
+                    if(map[i][j] == 0) colIndices.append(j);
+                }
+                std::shuffle(colIndices.begin(), colIndices.end(), rng);
+                
+                // 在同一行放置配对
+                for(int k = 0; k < colIndices.size() - 1 && pairIdx < pairCount; k += 2) {
+                    int val = (pairIdx % typeCount) + 1;
+                    map[i][colIndices[k]] = val;
+                    map[i][colIndices[k+1]] = val;
+                    pairIdx++;
+                }
+            }
+            
+            // 填充剩余的，尽量在同一列
+            for(int j = 0; j < cols && pairIdx < pairCount; j++) {
+                QVector<int> rowIndices;
+                for(int i = 0; i < rows; i++) {
+                    if(map[i][j] == 0) rowIndices.append(i);
+                }
+                for(int k = 0; k < rowIndices.size() - 1 && pairIdx < pairCount; k += 2) {
+                    int val = (pairIdx % typeCount) + 1;
+                    map[rowIndices[k]][j] = val;
+                    map[rowIndices[k+1]][j] = val;
+                    pairIdx++;
+                }
+            }
+            
+            // 最后填充剩余的
+            int valIdx = pairIdx * 2;
+            for(int i = 0; i < rows && valIdx < values.size(); i++) {
+                for(int j = 0; j < cols && valIdx < values.size(); j++) {
+                    if(map[i][j] == 0) {
+                        map[i][j] = values[valIdx++];
+                    }
+                }
+            }
+            break;
+        }
+        
+        case INTERMEDIATE: {
+            // 中级：生成较多两拐的配对
+            // 完全随机打乱
+            std::shuffle(values.begin(), values.end(), rng);
+            
+            int idx = 0;
+            for(int i = 0; i < rows; i++) {
+                for(int j = 0; j < cols; j++) {
+                    map[i][j] = values[idx++];
+                }
+            }
+            
+            // 验证并调整，确保有解
+            int attempts = 0;
+            while(!BoardEngine::verifySolvabilityQuick(map) && attempts < 50) {
+                // 重新打乱
+                std::shuffle(values.begin(), values.end(), rng);
+                idx = 0;
+                for(int i = 0; i < rows; i++) {
+                    for(int j = 0; j < cols; j++) {
+                        map[i][j] = values[idx++];
+                    }
+                }
+                attempts++;
+            }
+            if (verifyRetries) *verifyRetries = attempts;
+            break;
+        }
+        
+        case ADVANCED: {
+            // 高级：完全随机，难度最高
+            std::shuffle(values.begin(), values.end(), rng);
+            
+            int idx = 0;
+            for(int i = 0; i < rows; i++) {
+                for(int j = 0; j < cols; j++) {
+                    map[i][j] = values[idx++];
+                }
+            }
+            
+            // 多次尝试，找到有解的布局
+            int attempts = 0;
+            while(!BoardEngine::verifySolvabilityQuick(map) && attempts < 200) {
+                std::shuffle(values.begin(), values.end(), rng);
+                idx = 0;
+                for(int i = 0; i < rows; i++) {
+                    for(int j = 0; j < cols; j++) {
+                        map[i][j] = values[idx++];
+                    }
+                }
+                attempts++;
+            }
+            if (verifyRetries) *verifyRetries = attempts;
+            break;
+        }
+    }
+    
+    return map;
+}
+
+// 每种图案至少约4对；不足36对的棋盘保持原来的8种，布局只取决于棋盘大小，与加载的图集无关
+int BoardEngine::typeCountFor(int rows, int cols) {
+    int pairCount = rows * cols / 2;
+    return qMin(pairCount, qMin(MAX_TILE_TYPES, qMax(8, pairCount / 4)));
+}
+
+int BoardEngine::pointsFor(Difficulty difficulty) {
+    switch(difficulty) {
+        case BEGINNER: return 5;
+        case PRIMARY: return 10;
+        case INTERMEDIATE: return 15;
+        case ADVANCED: return 20;
+    }
+    return 10;
+}
+
+QVector<QPoint> BoardEngine::shuffleRemaining(GameRng& rng, QVector<int>* permutation) {
+    QVector<QPoint> positions = occupiedCells();
+    
+    // 打乱下标而不是图案：交换顺序相同，结果与直接打乱图案一致，同时得到置换
+    QVector<int> order(positions.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+    
+    applyPermutation(positions, order, false);
+    pushHistory({true, 0, 0, 0, {}, order});
+    if (permutation) *permutation = order;
+    return positions;
+}
+
+bool BoardEngine::verifySolvabilityQuick(const QVector<QVector<int>>& layout) {
+    QVector<QVector<int>> tempMap = layout;
+    const int rows = tempMap.size();
+    const int cols = rows > 0 ? tempMap[0].size() : 0;
+    
+    // 尝试消除所有配对
+    int eliminated = 0;
+    while(eliminated < rows * cols) {
+        bool found = false;
+        QPoint a, b;
+        
+        for(int i = 0; i < rows && !found; i++) {
+            for(int j = 0; j < cols && !found; j++) {
+                if(tempMap[i][j] == 0) continue;
+                for(int x = i; x < rows && !found; x++) {
+                    for(int y = 0; y < cols && !found; y++) {
+                        if((i == x && j == y) || tempMap[x][y] == 0) continue;
+                        if(tempMap[i][j] == tempMap[x][y]) {
+                            int maxTurns = 2;
+                            if(canLinkInternal(tempMap, QPoint(i,j), QPoint(x,y), maxTurns)) {
+                                a = QPoint(i, j);
+                                b = QPoint(x, y);
+                                found = true;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        
+        if(!found) break;
+        
+        tempMap[a.x()][a.y()] = 0;
+        tempMap[b.x()][b.y()] = 0;
+        eliminated += 2;
+    }
+    
+    return eliminated == rows * cols;
+}
+
+// canLink的内部版本，使用临时地图；不访问成员，可在工作线程上调用
+bool BoardEngine::canLinkInternal(const QVector<QVector<int>>& tempMap, const QPoint& a, const QPoint& b, int maxTurns) {
+    const int rows = tempMap.size();
+    const int cols = rows > 0 ? tempMap[0].size() : 0;
+    
+    // 直连
+    if(a.x() == b.x()) {
+        int minC = qMin(a.y(), b.y());
+        int maxC = qMax(a.y(), b.y());
+        bool clear = true;
+        for(int c = minC + 1; c < maxC; c++) {
+            if(tempMap[a.x()][c] != 0) { clear = false; break; }
+        }
+        if(clear) return true;
+    }
+    if(a.y() == b.y()) {
+        int minR = qMin(a.x(), b.x());
+        int maxR = qMax(a.x(), b.x());
+        bool clear = true;
+        for(int r = minR + 1; r < maxR; r++) {
+            if(tempMap[r][a.y()] != 0) { clear = false; break; }
+        }
+        if(clear) return true;
+    }
+    
+    if(maxTurns < 1) return false;
+    
+    // 一拐
+    QPoint corner1(a.x(), b.y());
+    if(corner1 != a && corner1 != b && tempMap[corner1.x()][corner1.y()] == 0) {
+        bool hClear = true, vClear = true;
+        int minC = qMin(a.y(), b.y());
+        int maxC = qMax(a.y(), b.y());
+        for(int c = minC + 1; c < maxC; c++) {
+            if(tempMap[a.x()][c] != 0) { hClear = false; break; }
+        }
+        int minR = qMin(a.x(), b.x());
+        int maxR = qMax(a.x(), b.x());
+        for(int r = minR + 1; r < maxR; r++) {
+            if(tempMap[r][b.y()] != 0) { vClear = false; break; }
+        }
+        if(hClear && vClear) return true;
+    }
+    
+    QPoint corner2(b.x(), a.y());
+    if(corner2 != a && corner2 != b && tempMap[corner2.x()][corner2.y()] == 0) {
+        bool vClear = true, hClear = true;
+        int minR = qMin(a.x(), b.x());
+        int maxR = qMax(a.x(), b.x());
+        for(int r = minR + 1; r < maxR; r++) {
+            if(tempMap[r][a.y()] != 0) { vClear = false; break; }
+        }
+        int minC = qMin(a.y(), b.y());
+        int maxC = qMax(a.y(), b.y());
+        for(int c = minC + 1; c < maxC; c++) {
+            if(tempMap[b.x()][c] != 0) { hClear = false; break; }
+        }
+        if(vClear && hClear) return true;
+    }
+    
+    if(maxTurns < 2) return false;
+    
+    // 两拐
+    for(int i = 0; i < rows; i++) {
+        QPoint p1(i, a.y());
+        QPoint p2(i, b.y());
+        if(p1 != a && p1 != b && p2 != a && p2 != b && 
+           tempMap[p1.x()][p1.y()] == 0 && tempMap[p2.x()][p2.y()] == 0) {
+            // 检查三条线段
+            bool ok = true;
+            int minR = qMin(a.x(), i);
+            int maxR = qMax(a.x(), i);
+            for(int r = minR + 1; r < maxR; r++) {
+                if(tempMap[r][a.y()] != 0) { ok = false; break; }
+            }
+            if(ok) {
+                int minC = qMin(a.y(), b.y());
+                int maxC = qMax(a.y(), b.y());
+                for(int c = minC + 1; c < maxC; c++) {
+                    if(tempMap[i][c] != 0) { ok = false; break; }
+                }
+            }
+            if(ok) {
+                minR = qMin(i, b.x());
+                maxR = qMax(i, b.x());
+                for(int r = minR + 1; r < maxR; r++) {
+                    if(tempMap[r][b.y()] != 0) { ok = false; break; }
+                }
+            }
+            if(ok) return true;
+        }
+    }
+    
+    for(int j = 0; j < cols; j++) {
+        QPoint p1(a.x(), j);
+        QPoint p2(b.x(), j);
+        if(p1 != a && p1 != b && p2 != a && p2 != b && 
+           tempMap[p1.x()][p1.y()] == 0 && tempMap[p2.x()][p2.y()] == 0) {
+            bool ok = true;
+            int minC = qMin(a.y(), j);
+            int maxC = qMax(a.y(), j);
+            for(int c = minC + 1; c < maxC; c++) {
+                if(tempMap[a.x()][c] != 0) { ok = false; break; }
+            }
+            if(ok) {
+                int minR = qMin(a.x(), b.x());
+                int maxR = qMax(a.x(), b.x());
+                for(int r = minR + 1; r < maxR; r++) {
+                    if(tempMap[r][j] != 0) { ok = false; break; }
+                }
+            }
+            if(ok) {
+                minC = qMin(j, b.y());
+                maxC = qMax(j, b.y());
+                for(int c = minC + 1; c < maxC; c++) {
+                    if(tempMap[b.x()][c] != 0) { ok = false; break; }
+                }
+            }
+            if(ok) return true;
+        }
+    }
+    
+    return false;
+}
+
+bool BoardEngine::canLink(const QPoint& a, const QPoint& b, int maxTurns) const {
+    if(maxTurns == -1) {
+        maxTurns = 2;
+    }
+    
+    // 直连
+    if(a.x() == b.x() && lineClearRow(a.x(), a.y(), b.y())) {
+        return true;
+    }
+    if(a.y() == b.y() && lineClearCol(a.y(), a.x(), b.x())) {
+        return true;
+    }
+    
+    if(maxTurns < 1) return false;
+    
+    // 一拐：先横后竖
+    QPoint corner1(a.x(), b.y());
+    if(corner1 != a && corner1 != b && at(corner1) == 0) {
+        if(lineClearRow(a.x(), a.y(), b.y()) && lineClearCol(b.y(), a.x(), b.x())) {
+            return true;
+        }
+    }
+    
+    // 一拐：先竖后横
+    QPoint corner2(b.x(), a.y());
+    if(corner2 != a && corner2 != b && at(corner2) == 0) {
+        if(lineClearCol(a.y(), a.x(), b.x()) && lineClearRow(b.x(), a.y(), b.y())) {
+            return true;
+        }
+    }
+    
+    if(maxTurns < 2) return false;
+    
+    // 两拐：竖-横-竖
+    for(int i = 0; i < rows; i++) {
+        QPoint p1(i, a.y());
+        QPoint p2(i, b.y());
+        if(p1 != a && p1 != b && p2 != a && p2 != b && 
+           at(p1) == 0 && at(p2) == 0) {
+            if(lineClearCol(a.y(), a.x(), i) && 
+               lineClearRow(i, a.y(), b.y()) && 
+               lineClearCol(b.y(), i, b.x())) {
+                return true;
+            }
+        }
+    }
+    
+    // 两拐：横-竖-横
+    for(int j = 0; j < cols; j++) {
+        QPoint p1(a.x(), j);
+        QPoint p2(b.x(), j);
+        if(p1 != a && p1 != b && p2 != a && p2 != b && 
+           at(p1) == 0 && at(p2) == 0) {
+            if(lineClearRow(a.x(), a.y(), j) && 
+               lineClearCol(j, a.x(), b.x()) && 
+               lineClearRow(b.x(), j, b.y())) {
+                return true;
+            }
+        }
+    }
+    
+    return false;
+}
+
+// 按图块类型枚举候选对，只比较同类图块；cancelled返回true时提前放弃
+bool BoardEngine::findHint(QPoint& a, QPoint& b, const std::function<bool()>& cancelled) const {
+    // 连接规则统一：所有难度都是最多2次转弯
+    for(int v = 1; v < typePositions.size(); v++) {
+        const QVector<quint32>& list = typePositions[v];
+        for(int i = 0; i < list.size(); i++) {
+            if(cancelled && cancelled()) return false;
+            QPoint pi(int(list[i]) / cols, int(list[i]) % cols);
+            for(int k = i + 1; k < list.size(); k++) {
+                QPoint pk(int(list[k]) / cols, int(list[k]) % cols);
+                if(canLink(pi, pk, 2)) {
+                    a = pi;
+                    b = pk;
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// findHint的内部版本，只读取传入的快照；cancelled返回true时提前放弃
+bool BoardEngine::findHintInternal(const QVector<QVector<int>>& tempMap, QPoint &a, QPoint &b,
+                                 const std::function<bool()>& cancelled) {
+    const int rows = tempMap.size();
+    const int cols = rows > 0 ? tempMap[0].size() : 0;
+    
+    for(int i = 0; i < rows; i++) {
+        for(int j = 0; j < cols; j++) {
+            if(tempMap[i][j] == 0) continue;
+            if(cancelled && cancelled()) return false;
+            for(int x = i; x < rows; x++) {
+                for(int y = 0; y < cols; y++) {
+                    if((i == x && j == y) || tempMap[x][y] == 0) continue;
+                    if(tempMap[i][j] == tempMap[x][y] &&
+                       canLinkInternal(tempMap, QPoint(i,j), QPoint(x,y), 2)) {
+                        a = QPoint(i, j);
+                        b = QPoint(x, y);
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+QVector<QPoint> BoardEngine::findPathInternal(const QPoint& a, const QPoint& b, int maxDepth) const {
+    QVector<QPoint> path;
+    path.append(a);
+    
+    // 直连
+    if(a.x() == b.x() && lineClearRow(a.x(), a.y(), b.y())) {
+        path.append(b);
+        return path;
+    }
+    if(a.y() == b.y() && lineClearCol(a.y(), a.x(), b.x())) {
+        path.append(b);
+        return path;
+    }
+    
+    // 一拐
+    if(maxDepth >= 1) {
+        QPoint corner1(a.x(), b.y());
+        if(corner1 != a && corner1 != b && at(corner1) == 0) {
+            if(lineClearRow(a.x(), a.y(), b.y()) && lineClearCol(b.y(), a.x(), b.x())) {
+                path.append(corner1);
+                path.append(b);
+                return path;
+            }
+        }
+        
+        QPoint corner2(b.x(), a.y());
+        if(corner2 != a && corner2 != b && at(corner2) == 0) {
+            if(lineClearCol(a.y(), a.x(), b.x()) && lineClearRow(b.x(), a.y(), b.y())) {
+                path.append(corner2);
+                path.append(b);
+                return path;
+            }
+        }
+    }
+    
+    // 两拐
+    if(maxDepth >= 2) {
+        for(int i = 0; i < rows; i++) {
+            QPoint p1(i, a.y());
+            QPoint p2(i, b.y());
+            if(p1 != a && p1 != b && p2 != a && p2 != b && 
+               at(p1) == 0 && at(p2) == 0) {
+                if(lineClearCol(a.y(), a.x(), i) && 
+                   lineClearRow(i, a.y(), b.y()) && 
+                   lineClearCol(b.y(), i, b.x())) {
+                    path.append(p1);
+                    path.append(p2);
+                    path.append(b);
+                    return path;
+                }
+            }
+        }
+        
+        for(int j = 0; j < cols; j++) {
+            QPoint p1(a.x(), j);
+            QPoint p2(b.x(), j);
+            if(p1 != a && p1 != b && p2 != a && p2 != b && 
+               at(p1) == 0 && at(p2) == 0) {
+                if(lineClearRow(a.x(), a.y(), j) && 
+                   lineClearCol(j, a.x(), b.x()) && 
+                   lineClearRow(b.x(), j, b.y())) {
+                    path.append(p1);
+                    path.append(p2);
+                    path.append(b);
+                    return path;
+                }
+            }
+        }
+    }
+    
+    return path;
+}
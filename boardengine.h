@@ -0,0 +1,148 @@
+#ifndef BOARDENGINE_H
+#define BOARDENGINE_H
+#include <QVector>
+#include <QPoint>
+#include <QByteArray>
+#include <QString>
+#include <functional>
+#include "gamerng.h"
+
+enum Difficulty {
+    BEGINNER,    // 入门级：直连比例高
+    PRIMARY,     // 初级：拐一个弯比例高
+    INTERMEDIATE,// 中级：拐2个弯比例高
+    ADVANCED     // 高级：最多3个弯
+};
+
+// 消除后剩余图块的移动规则（关卡变体）
+enum ShiftRule {
+    SHIFT_NONE,   // 不移动
+    SHIFT_DOWN,   // 同列图块下落
+    SHIFT_LEFT,   // 同行图块左移
+    SHIFT_CENTER  // 同行图块向中线靠拢
+};
+
+// 一次图块移动，供界面只为真正移动的图块播放动画
+struct TileMove {
+    QPoint from;
+    QPoint to;
+    int value;
+};
+
+// 棋盘引擎：保存地图与派生索引（行/列占用位图、每种图块的位置），
+// 实现连线规则和移动规则。不依赖任何界面对象。
+class BoardEngine {
+public:
+    BoardEngine(int r = 0, int c = 0);
+
+    void setMap(const QVector<QVector<int>>& layout); // 载入整盘布局，重建一次索引
+    // 直接载入按行优先打包的图案（每格bytesPerTile字节），大小不符时返回false
+    bool setPacked(int r, int c, const QByteArray& packed, int bytesPerTile);
+    const QByteArray& packedTiles() const { return tiles; }
+    int tileWidth() const { return tileBytes; } // 每格字节数
+    // 每格2字节时内存中按本机字节序存放，写盘和传输统一为小端；转换正反两个方向相同，
+    // 小端机器上直接共享原数据
+    static QByteArray tilesLittleEndian(const QByteArray& packed, int bytesPerTile);
+    // 不带撤销历史的副本，与本引擎隐式共享图案和索引，只增加引用计数；
+    // 可交给工作线程只读使用，本引擎之后的修改会自行分离
+    BoardEngine snapshot() const;
+    int rowCount() const { return rows; }
+    int colCount() const { return cols; }
+    int at(int r, int c) const {
+        const int k = r * cols + c;
+        return tileBytes == 1 ? int(quint8(tiles.constData()[k]))
+                              : int(reinterpret_cast<const quint16*>(tiles.constData())[k]);
+    }
+    int at(const QPoint& p) const { return at(p.x(), p.y()); }
+    QVector<QVector<int>> cells() const; // 展开为二维数组，逐格复制
+    int remainingCount() const { return remaining; }
+    QVector<QPoint> positionsOf(int value) const;
+
+    // 各部分占用的堆内存（字节）
+    struct MemoryUsage {
+        qint64 tiles;
+        qint64 occupancy;
+        qint64 typeIndex;
+        qint64 total() const { return tiles + occupancy + typeIndex; }
+    };
+    MemoryUsage memoryUsage() const;
+    QString memoryReport() const;
+
+    void setShiftRule(ShiftRule rule) { shiftRule = rule; }
+    ShiftRule getShiftRule() const { return shiftRule; }
+
+    void setCell(const QPoint& p, int value);              // 修改单格，增量维护索引
+    QVector<TileMove> removePair(const QPoint& a, const QPoint& b); // 消除并按规则移动，返回移动列表
+    // 打乱剩余图块，返回涉及的格子（按行优先）；permutation[k]为第k个格子新图案原来所在格子的序号
+    QVector<QPoint> shuffleRemaining(GameRng& rng, QVector<int>* permutation = nullptr);
+
+    // 一步操作的紧凑记录：消除记两个格子编号和图案，以及规则移动；重排只引用置换（隐式共享）
+    struct MoveRecord {
+        bool shuffle;
+        quint32 a, b;
+        int value;
+        QVector<TileMove> shifts;
+        QVector<int> permutation;
+    };
+    // 撤销/重做removePair和shuffleRemaining，只改动涉及的格子，索引随setCell增量恢复。
+    // changed返回值被改动的格子，供界面刷新；新的消除或重排会清空重做栈，setMap清空全部历史。
+    // 历史默认关闭（服务器会话、机器人、回放检查点都不需要），需要撤销时用setHistoryLimit打开
+    void setHistoryLimit(int limit); // 最多保留limit步，超出时丢弃最早的；0表示不记录
+    int historyLimit() const { return maxHistory; }
+    bool canUndo() const { return !undoStack.isEmpty(); }
+    bool canRedo() const { return !redoStack.isEmpty(); }
+    bool undo(QVector<QPoint>* changed = nullptr, MoveRecord* record = nullptr);
+    bool redo(QVector<QPoint>* changed = nullptr, MoveRecord* record = nullptr);
+    int historyDepth() const { return undoStack.size(); }
+    void clearHistory();
+
+    bool lineClearRow(int r, int c1, int c2) const;
+    bool lineClearCol(int c, int r1, int r2) const;
+    bool canLink(const QPoint& a, const QPoint& b, int maxTurns = -1) const;
+    bool findHint(QPoint& a, QPoint& b, const std::function<bool()>& cancelled = nullptr) const;
+    QVector<QPoint> findPathInternal(const QPoint& a, const QPoint& b, int maxDepth) const;
+
+    static bool canLinkInternal(const QVector<QVector<int>>& tempMap, const QPoint& a, const QPoint& b, int maxTurns);
+    static bool findHintInternal(const QVector<QVector<int>>& tempMap, QPoint &a, QPoint &b,
+                                 const std::function<bool()>& cancelled = nullptr);
+    static bool verifySolvabilityQuick(const QVector<QVector<int>>& layout);
+    // 按难度生成布局；随机数只来自rng，同一状态和图案种类数总是得到同一布局。
+    // typeCount为0时使用typeCountFor
+    static QVector<QVector<int>> generateLayout(int rows, int cols, Difficulty difficulty, GameRng& rng,
+                                                int *verifyRetries = nullptr, int typeCount = 0);
+    static int pointsFor(Difficulty difficulty); // 每消除一对的得分
+    static int typeCountFor(int rows, int cols); // 生成布局时使用的图案种类数
+    static const int MAX_TILE_TYPES = 1024;
+
+private:
+    int rows, cols;
+    // 图案按行优先紧凑存放：种类不超过255时每格1字节，否则2字节
+    QByteArray tiles;
+    int tileBytes;
+    ShiftRule shiftRule;
+    int remaining;
+
+    // 占用位图：每行/每列按64位一个字存放，rowBits[r*rowWords+w]的第k位表示(r, w*64+k)有图块
+    int rowWords, colWords;
+    QVector<quint64> rowBits;
+    QVector<quint64> colBits;
+    QVector<QVector<quint32>> typePositions; // typePositions[v]：值为v的所有格子编号（行*列数+列）
+    QVector<MoveRecord> undoStack;
+    QVector<MoveRecord> redoStack;
+    int maxHistory;
+
+    void storeTile(int k, int value);
+    void widenTiles(); // 出现大于255的图案时改为每格2字节
+
+    void rebuildIndex();
+    void indexAdd(const QPoint& p, int value);
+    void indexRemove(const QPoint& p, int value);
+    void compactLine(const QVector<QPoint>& line, QVector<TileMove>& moves);
+    void applyShift(const QPoint& freed, QVector<TileMove>& moves);
+    QVector<QPoint> occupiedCells() const; // 按行优先的非空格子
+    void applyPermutation(const QVector<QPoint>& positions, const QVector<int>& permutation, bool inverse);
+    void pushHistory(const MoveRecord& record);
+    static bool bitsClear(const quint64* words, int from, int to);
+};
+
+#endif
@@ -0,0 +1,149 @@
+#include "cloudleaderboard.h"
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QUrlQuery>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QFile>
+#include <QDebug>
+
+namespace {
+const quint32 CACHE_MAGIC = 0x4C4C4B43; // "LLKC"
+const quint16 CACHE_VERSION = 1;
+}
+
+CloudLeaderboard::CloudLeaderboard(QNetworkAccessManager* nam, const QString& cachePath, QObject* parent)
+    : QObject(parent), nam(nam), cachePath(cachePath), cacheValid(false), page(0), fetching(false)
+{
+    loadCache();
+}
+
+void CloudLeaderboard::fetch(const QUrl& url) {
+    if (fetching) return; // 上一次下载完成时会发出loaded
+    endpoint = url;
+    page = 0;
+    fetching = true;
+    pending.clear();
+    pendingIds.clear();
+    requestPage();
+}
+
+void CloudLeaderboard::requestPage() {
+    QUrl url = endpoint;
+    QUrlQuery query(url);
+    query.addQueryItem("page", QString::number(page));
+    query.addQueryItem("pageSize", QString::number(PAGE_SIZE));
+    url.setQuery(query);
+
+    QNetworkRequest request(url);
+    // 只对第一页做条件请求，内容没变时整个下载只有这一次304往返
+    if (page == 0 && cacheValid) {
+        if (!etag.isEmpty()) request.setRawHeader("If-None-Match", etag);
+        if (!lastModified.isEmpty()) request.setRawHeader("If-Modified-Since", lastModified);
+    }
+    QNetworkReply* reply = nam->get(request);
+    connect(reply, &QNetworkReply::finished, this, &CloudLeaderboard::onPageFinished);
+}
+
+void CloudLeaderboard::onPageFinished() {
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    if (!reply) return;
+    reply->deleteLater();
+
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (page == 0 && status == 304) {
+        fetching = false;
+        emit loaded(records, false);
+        return;
+    }
+    if (reply->error() != QNetworkReply::NoError) {
+        qDebug() << "Failed to load cloud records:" << reply->errorString();
+        fetching = false;
+        emit loaded(records, false); // 离线时仍显示上次的缓存
+        return;
+    }
+    if (page == 0) {
+        pendingEtag = reply->rawHeader("ETag");
+        pendingLastModified = reply->rawHeader("Last-Modified");
+    }
+
+    QJsonObject root = QJsonDocument::fromJson(reply->readAll()).object();
+    QJsonArray recordsArray = root["records"].toArray();
+    for (const QJsonValue& value : recordsArray) {
+        QJsonObject obj = value.toObject();
+        Record r;
+        r.id = obj["id"].toInt();
+        r.score = obj["score"].toInt();
+        r.time = obj["time"].toInt();
+        r.playerName = obj["playerName"].toString();
+        r.difficulty = obj["difficulty"].toString();
+        r.dateTime = obj["dateTime"].toString();
+        if (pendingIds.contains(r.id)) continue;
+        pendingIds.insert(r.id);
+        pending.append(r);
+    }
+
+    // 不足一页说明已经是最后一页
+    if (recordsArray.size() >= PAGE_SIZE) {
+        page++;
+        requestPage();
+        return;
+    }
+
+    records = pending;
+    etag = pendingEtag;
+    lastModified = pendingLastModified;
+    cacheValid = true;
+    pending.clear();
+    pendingIds.clear();
+    fetching = false;
+    saveCache();
+    emit loaded(records, true);
+}
+
+void CloudLeaderboard::loadCache() {
+    QFile f(cachePath);
+    if (!f.open(QIODevice::ReadOnly)) return;
+    QDataStream in(&f);
+    in.setByteOrder(QDataStream::LittleEndian);
+    quint32 magic;
+    quint16 version;
+    qint32 count;
+    in >> magic >> version;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION) return;
+    in >> etag >> lastModified >> count;
+
+    QVector<Record> rs;
+    for (int i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        Record r;
+        qint32 id, score, time;
+        in >> id >> score >> time >> r.playerName >> r.difficulty >> r.dateTime;
+        r.id = id;
+        r.score = score;
+        r.time = time;
+        rs.append(r);
+    }
+    if (in.status() != QDataStream::Ok) {
+        // 缓存损坏，下次完整下载
+        etag.clear();
+        lastModified.clear();
+        return;
+    }
+    records = rs;
+    cacheValid = true;
+}
+
+void CloudLeaderboard::saveCache() {
+    QSaveFile f(cachePath);
+    if (!f.open(QIODevice::WriteOnly)) return;
+    QDataStream out(&f);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << CACHE_MAGIC << CACHE_VERSION << etag << lastModified << qint32(records.size());
+    for (const Record& r : records) {
+        out << qint32(r.id) << qint32(r.score) << qint32(r.time) << r.playerName << r.difficulty << r.dateTime;
+    }
+    f.commit();
+}
@@ -0,0 +1,49 @@
+#ifndef CLOUDLEADERBOARD_H
+#define CLOUDLEADERBOARD_H
+#include <QObject>
+#include <QUrl>
+#include <QSet>
+#include <QNetworkAccessManager>
+#include "recordmanager.h"
+
+// 云端排行榜的本地缓存：结果连同ETag/Last-Modified保存在磁盘上，
+// 下次只发一个条件请求，服务器返回304时直接使用缓存；有变化时再分页下载全部记录。
+class CloudLeaderboard : public QObject {
+    Q_OBJECT
+public:
+    CloudLeaderboard(QNetworkAccessManager* nam, const QString& cachePath, QObject* parent = nullptr);
+    void fetch(const QUrl& endpoint);
+    bool hasCache() const { return cacheValid; }
+    const QVector<Record>& cached() const { return records; }
+
+    static const int PAGE_SIZE = 100;
+
+signals:
+    void loaded(const QVector<Record>& records, bool changed); // changed为false表示缓存仍有效或请求失败
+
+private slots:
+    void onPageFinished();
+
+private:
+    QNetworkAccessManager* nam;
+    QString cachePath;
+    bool cacheValid;
+    QVector<Record> records;   // 缓存的云端记录
+    QByteArray etag;
+    QByteArray lastModified;
+
+    // 正在进行的一次分页下载
+    QUrl endpoint;
+    int page;
+    bool fetching;
+    QVector<Record> pending;
+    QSet<int> pendingIds;      // 翻页期间数据变化可能导致重复，按id去重
+    QByteArray pendingEtag;
+    QByteArray pendingLastModified;
+
+    void requestPage();
+    void loadCache();
+    void saveCache();
+};
+
+#endif
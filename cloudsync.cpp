@@ -0,0 +1,240 @@
+#include "cloudsync.h"
+#include "recordstorage.h"
+#include "outbox.h"
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QDataStream>
+#include <QFile>
+#include <QUuid>
+#include <QCryptographicHash>
+#include <QDebug>
+
+namespace {
+quint32 crc32(const QByteArray& data) {
+    static const QVector<quint32> table = []() {
+        QVector<quint32> t(256);
+        for (quint32 i = 0; i < 256; i++) {
+            quint32 c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    quint32 crc = 0xFFFFFFFFu;
+    for (char ch : data) {
+        crc = table[(crc ^ quint8(ch)) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void appendLE32(QByteArray& out, quint32 v) {
+    for (int i = 0; i < 4; i++) {
+        out.append(char((v >> (8 * i)) & 0xFF));
+    }
+}
+}
+
+CloudSync::CloudSync(RecordStorage* store, QNetworkAccessManager* nam, QObject* parent)
+    : QObject(parent), store(store), nam(nam), statePath(store->name() + ".sync"),
+      enqueuedOffset(0), inflightLast(0), inflight(false), retryCount(0)
+{
+    endpoint = defaultEndpoint();
+    
+    batchTimer = new QTimer(this);
+    batchTimer->setSingleShot(true);
+    connect(batchTimer, &QTimer::timeout, this, &CloudSync::flush);
+    retryTimer = new QTimer(this);
+    retryTimer->setSingleShot(true);
+    connect(retryTimer, &QTimer::timeout, this, &CloudSync::flush);
+    
+    outbox = new Outbox("outbox.dat");
+    outbox->open();
+    loadState();
+    enqueueNewRecords(); // 上次运行写入日志但未进入队列的记录
+    
+    // 网络恢复可达时立即清空队列，而不是等退避计时器
+    if (QNetworkInformation::loadBackendByFeatures(QNetworkInformation::Feature::Reachability)) {
+        connect(QNetworkInformation::instance(), &QNetworkInformation::reachabilityChanged,
+                this, &CloudSync::onReachabilityChanged);
+    }
+    
+    // 上次运行遗留的待上传条目，稍后补传
+    if (outbox->pendingCount() > 0) {
+        batchTimer->start(BATCH_DELAY_MS);
+    }
+}
+
+CloudSync::~CloudSync() {
+    delete outbox;
+}
+
+QUrl CloudSync::defaultEndpoint() {
+    // 注意：这里使用模拟的云端API，可用环境变量LLK_RECORDS_URL替换
+    QByteArray envUrl = qgetenv("LLK_RECORDS_URL");
+    return envUrl.isEmpty() ? QUrl("https://your-api-endpoint.com/records")
+                            : QUrl(QString::fromUtf8(envUrl));
+}
+
+void CloudSync::recordAdded() {
+    enqueueNewRecords();
+    if (outbox->pendingCount() >= BATCH_MAX) {
+        flush();
+    } else if (!batchTimer->isActive() && !retryTimer->isActive()) {
+        batchTimer->start(BATCH_DELAY_MS);
+    }
+}
+
+// 把记录日志中enqueuedOffset之后的记录转入上传队列
+void CloudSync::enqueueNewRecords() {
+    while (enqueuedOffset < store->endOffset()) {
+        QVector<Record> records;
+        QVector<quint32> seqs;
+        quint64 next = enqueuedOffset;
+        if (store->readFrom(enqueuedOffset, BATCH_MAX, records, seqs, next) == 0) break;
+        for (int i = 0; i < records.size(); i++) {
+            const Record& r = records[i];
+            QJsonObject recordObj;
+            recordObj["score"] = r.score;
+            recordObj["time"] = r.time;
+            recordObj["playerName"] = r.playerName;
+            recordObj["difficulty"] = r.difficulty;
+            recordObj["dateTime"] = r.dateTime;
+            recordObj["clientSeq"] = qint64(seqs[i]);
+            outbox->enqueue(QJsonDocument(recordObj).toJson(QJsonDocument::Compact));
+        }
+        enqueuedOffset = next;
+        saveState();
+    }
+}
+
+void CloudSync::onReachabilityChanged(QNetworkInformation::Reachability reachability) {
+    if (reachability != QNetworkInformation::Reachability::Online) return;
+    if (outbox->pendingCount() == 0) return;
+    retryTimer->stop();
+    retryCount = 0;
+    flush();
+}
+
+void CloudSync::flush() {
+    batchTimer->stop();
+    // 请求在途或处于退避等待中时不重复发送，完成/重试时会继续处理积压
+    if (inflight || retryTimer->isActive()) return;
+    
+    QVector<OutboxEntry> entries = outbox->peek(BATCH_MAX);
+    if (entries.isEmpty()) return;
+    
+    // 多条队列条目合并为一个请求；每条带自己的幂等键，整批的键由各条的键派生，重试时不变
+    QJsonArray recordsArray;
+    QCryptographicHash batchKey(QCryptographicHash::Sha1);
+    for (const OutboxEntry& e : entries) {
+        QJsonObject recordObj = QJsonDocument::fromJson(e.payload).object();
+        recordObj["idempotencyKey"] = QUuid::fromRfc4122(e.key).toString(QUuid::WithoutBraces);
+        recordsArray.append(recordObj);
+        batchKey.addData(e.key);
+    }
+    QJsonObject root;
+    root["deviceId"] = deviceId;
+    root["records"] = recordsArray;
+    QByteArray body = gzip(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    
+    QNetworkRequest request(endpoint);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    request.setRawHeader("Content-Encoding", "gzip");
+    request.setRawHeader("Idempotency-Key", batchKey.result().toHex());
+    QNetworkReply* reply = nam->post(request, body);
+    connect(reply, &QNetworkReply::finished, this, &CloudSync::onReplyFinished);
+    inflight = true;
+    inflightLast = entries.last().offset;
+}
+
+void CloudSync::onReplyFinished() {
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    inflight = false;
+    bool success = reply && reply->error() == QNetworkReply::NoError;
+    int status = reply ? reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() : 0;
+    if (success) {
+        qDebug() << "Records synced to cloud successfully";
+        outbox->ack(inflightLast);
+        retryCount = 0;
+        emit syncFinished(true);
+        // 积压超过一批时继续上传下一批
+        if (outbox->pendingCount() > 0) flush();
+    } else if (isPermanentFailure(status)) {
+        // 服务器拒绝这一批，重试也不会成功；丢弃后继续上传后面的条目，记录仍保存在本地
+        qDebug() << "Cloud rejected record batch with status" << status << ", dropping it";
+        outbox->ack(inflightLast);
+        retryCount = 0;
+        emit syncFinished(false);
+        if (outbox->pendingCount() > 0) flush();
+    } else {
+        qDebug() << "Failed to sync to cloud:" << (reply ? reply->errorString() : QString());
+        emit syncFinished(false);
+        scheduleRetry();
+    }
+    if (reply) {
+        reply->deleteLater();
+    }
+}
+
+// 指数退避，在[delay/2, delay]内随机取值，避免大量客户端同时重试
+void CloudSync::scheduleRetry() {
+    qint64 delay = qMin<qint64>(qint64(RETRY_BASE_MS) << qMin(retryCount, 16), RETRY_MAX_MS);
+    int half = int(delay / 2);
+    int ms = half + int(QRandomGenerator::global()->bounded(half + 1));
+    retryCount++;
+    qDebug() << "Retrying cloud sync in" << ms << "ms";
+    retryTimer->start(ms);
+}
+
+// 4xx中只有超时和限流值得重试，其余说明请求本身有问题
+bool CloudSync::isPermanentFailure(int httpStatus) {
+    return httpStatus >= 400 && httpStatus < 500 && httpStatus != 408 && httpStatus != 429;
+}
+
+bool CloudSync::readState(const QString& path, quint64& offset, QString& deviceId) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    QDataStream in(&f);
+    in >> offset >> deviceId;
+    return in.status() == QDataStream::Ok;
+}
+
+void CloudSync::writeState(const QString& path, quint64 offset, const QString& deviceId) {
+    QFile f(path);
+    if (f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QDataStream out(&f);
+        out << offset << deviceId;
+    }
+}
+
+void CloudSync::loadState() {
+    readState(statePath, enqueuedOffset, deviceId);
+    if (enqueuedOffset > store->endOffset()) {
+        enqueuedOffset = store->endOffset(); // 日志尾部损坏被截断过
+    }
+    if (deviceId.isEmpty()) {
+        deviceId = QUuid::createUuid().toString(QUuid::WithoutBraces);
+        saveState();
+    }
+}
+
+void CloudSync::saveState() {
+    writeState(statePath, enqueuedOffset, deviceId);
+}
+
+// qCompress输出为4字节长度 + zlib流（2字节头、deflate数据、4字节adler32），
+// 取出其中的deflate数据，加上gzip头和CRC32/长度尾
+QByteArray CloudSync::gzip(const QByteArray& data) {
+    QByteArray z = qCompress(data, 6);
+    QByteArray out("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+    out.append(z.constData() + 6, z.size() - 6 - 4);
+    appendLE32(out, crc32(data));
+    appendLE32(out, quint32(data.size()));
+    return out;
+}
@@ -0,0 +1,63 @@
+#ifndef CLOUDSYNC_H
+#define CLOUDSYNC_H
+#include <QObject>
+#include <QUrl>
+#include <QTimer>
+#include <QNetworkAccessManager>
+#include <QNetworkInformation>
+
+class RecordStorage;
+class Outbox;
+
+// 增量云同步：新记录从记录日志转入持久化的上传队列（Outbox），
+// 队列中的条目合并为gzip压缩的批量请求上传，失败后按带抖动的指数退避重试，
+// 网络恢复可达时立即继续。
+class CloudSync : public QObject {
+    Q_OBJECT
+public:
+    CloudSync(RecordStorage* store, QNetworkAccessManager* nam, QObject* parent = nullptr);
+    ~CloudSync();
+    void setEndpoint(const QUrl& url) { endpoint = url; } // 测试时可指向本地HTTP服务
+    QUrl getEndpoint() const { return endpoint; }
+    static QUrl defaultEndpoint(); // 环境变量LLK_RECORDS_URL，未设置时为默认地址
+    // 同步状态文件（存储名 + ".sync"）：已转入上传队列的位置和设备ID，切换存储后端时据此迁移
+    static bool readState(const QString& path, quint64& offset, QString& deviceId);
+    static void writeState(const QString& path, quint64 offset, const QString& deviceId);
+    void recordAdded(); // 有新记录入库，攒够一批或等待片刻后上传
+    void flush();       // 立即上传队列中的记录
+
+    static const int BATCH_MAX = 50;           // 单个请求最多记录数
+    static const int BATCH_DELAY_MS = 10000;   // 攒批等待时间
+    static const int RETRY_BASE_MS = 2000;
+    static const int RETRY_MAX_MS = 5 * 60 * 1000;
+
+signals:
+    void syncFinished(bool success);
+
+private slots:
+    void onReplyFinished();
+    void onReachabilityChanged(QNetworkInformation::Reachability reachability);
+
+private:
+    RecordStorage* store;
+    QNetworkAccessManager* nam;
+    Outbox* outbox;
+    QUrl endpoint;
+    QTimer* batchTimer;
+    QTimer* retryTimer;
+    QString statePath;
+    QString deviceId;
+    quint64 enqueuedOffset; // 记录日志中已转入上传队列的位置
+    quint64 inflightLast;   // 在途请求中最后一条在队列文件中的位置
+    bool inflight;
+    int retryCount;
+
+    void enqueueNewRecords();
+    void loadState();
+    void saveState();
+    void scheduleRetry();
+    static bool isPermanentFailure(int httpStatus);
+    static QByteArray gzip(const QByteArray& data);
+};
+
+#endif
@@ -1,4 +1,7 @@
 #include "gameboard.h"
+#include "startuptrace.h"
+#include "spectatorfeed.h"
+#include "telemetry.h"
 #include <QRandomGenerator>
 #include <QPainter>
 #include <QPixmap>
@@ -16,15 +19,48 @@
 
 GameBoard::GameBoard(int r,int c,QWidget *parent)
     : QWidget(parent), rows(r), cols(c), hasFirst(false), 
-      difficulty(PRIMARY), solveStepIndex(0), pairsRemoved(0), connectionLine(nullptr)
+      difficulty(PRIMARY), solvePending(false), pairsRemoved(0), bonusPairs(0), connectionLine(nullptr),
+      boardRevision(0), stuckCacheValid(false), stuckCache(false),
+      gameSeed(QRandomGenerator::global()->generate64()), rng(gameSeed), spectators(nullptr)
 {
+    StartupTrace::Scope trace("GameBoard");
     grid = new QGridLayout(this);
     grid->setSpacing(0); // 图案紧挨着，无间距
     grid->setContentsMargins(0, 0, 0, 0);
-    solveTimer = new QTimer(this);
-    connect(solveTimer, &QTimer::timeout, this, &GameBoard::onAnimationFinished);
-    connectionTimer = new QTimer(this);
-    connect(connectionTimer, &QTimer::timeout, this, &GameBoard::onConnectionAnimationFinished);
+    scheduler = new GameScheduler(this);
+    engine.setHistoryLimit(HISTORY_LIMIT);
+    connectionEvent = 0;
+    hintRequestUs = 0;
+    stuckRequestUs = 0;
+    pendingRemovals = 0;
+    
+    // 提示与僵局检测在工作线程上运行，只接受与当前棋盘版本一致的结果
+    analyzer = new BoardAnalyzer(this);
+    connect(analyzer, &BoardAnalyzer::hintReady, this,
+            [this](quint64 revision, bool found, const QPoint& a, const QPoint& b) {
+        if (revision != boardRevision) return;
+        if (hintRequestUs) {
+            Telemetry::record(Telemetry::HINT_LATENCY, Telemetry::nowUs() - hintRequestUs, 0);
+            hintRequestUs = 0;
+        }
+        cacheStuck(!found);
+        if (found) hints.insert(engine, a, b);
+        emit hintReady(found, a, b);
+    });
+    connect(analyzer, &BoardAnalyzer::stuckChecked, this, [this](quint64 revision, bool stuck) {
+        if (revision != boardRevision) return;
+        if (stuckRequestUs) {
+            Telemetry::record(Telemetry::STUCK_CHECK, Telemetry::nowUs() - stuckRequestUs, stuck);
+            stuckRequestUs = 0;
+        }
+        cacheStuck(stuck);
+        emit stuckChecked(stuck);
+    });
+    // 自动求解与提示按钮共用同一个后台查询；棋盘在查询期间变化时旧结果被丢弃，重新查询
+    connect(this, &GameBoard::hintReady, this, &GameBoard::onSolveHint);
+    connect(this, &GameBoard::boardChanged, this, [this]() {
+        if (solvePending) requestHint();
+    });
     
     loadImages();
     generateSolvableMap();
@@ -37,7 +73,7 @@ GameBoard::~GameBoard() {
 }
 
 void GameBoard::loadImages() {
-    imageCache.clear();
+    StartupTrace::Scope trace("loadImages");
     
     // 获取应用程序目录 - 尝试多种方式
     QString basePath;
@@ -45,30 +81,37 @@ void GameBoard::loadImages() {
     // 方法1: 应用程序所在目录
     QDir appDir(QApplication::applicationDirPath());
     basePath = appDir.absolutePath();
-    qDebug() << "Application dir:" << basePath;
     
     // 方法2: 当前工作目录
     QDir workDir = QDir::current();
     QString workPath = workDir.absolutePath();
-    qDebug() << "Working dir:" << workPath;
     
-    for (int i = 1; i <= 8; i++) {
-        QStringList paths = {
+    auto candidates = [&](const QString& fileName) {
+        return QStringList{
             // 应用程序目录
-            QDir::cleanPath(basePath + "/images/" + QString::number(i) + ".jpg"),
-            QDir::cleanPath(basePath + "/../images/" + QString::number(i) + ".jpg"),
+            QDir::cleanPath(basePath + "/images/" + fileName),
+            QDir::cleanPath(basePath + "/../images/" + fileName),
             // 工作目录
-            QDir::cleanPath(workPath + "/images/" + QString::number(i) + ".jpg"),
-            QDir::cleanPath(workPath + "/../images/" + QString::number(i) + ".jpg"),
+            QDir::cleanPath(workPath + "/images/" + fileName),
+            QDir::cleanPath(workPath + "/../images/" + fileName),
             // 相对路径
-            QString("images/%1.jpg").arg(i),
-            QString("./images/%1.jpg").arg(i),
-            QString("../images/%1.jpg").arg(i)
+            "images/" + fileName,
+            "./images/" + fileName,
+            "../images/" + fileName
         };
-        
+    };
+    
+    // 优先使用图集：一张精灵图加清单，图案种类不受限制
+    for (const QString& manifestPath : candidates("tiles.json")) {
+        if (QFileInfo::exists(manifestPath) && tileSet.loadManifest(manifestPath)) return;
+    }
+    
+    // 没有图集时使用逐张的1.jpg~8.jpg
+    QVector<QPixmap> images;
+    for (int i = 1; i <= 8; i++) {
+        QStringList paths = candidates(QString::number(i) + ".jpg");
         QPixmap pix;
         bool loaded = false;
-        QString loadedPath;
         
         for (const QString& imagePath : paths) {
             QFileInfo fi(imagePath);
@@ -76,8 +119,6 @@ void GameBoard::loadImages() {
                 pix.load(imagePath);
                 if (!pix.isNull()) {
                     loaded = true;
-                    loadedPath = imagePath;
-                    qDebug() << "Successfully loaded image" << i << "from:" << imagePath;
                     break;
                 } else {
                     qDebug() << "Failed to load pixmap from:" << imagePath;
@@ -86,27 +127,15 @@ void GameBoard::loadImages() {
         }
         
         if (!loaded) {
-            // 如果图片加载失败，创建彩色占位符
-            pix = QPixmap(50, 50);
-            QColor colors[] = {
-                QColor(255, 100, 100), QColor(100, 255, 100), QColor(100, 100, 255),
-                QColor(255, 255, 100), QColor(255, 100, 255), QColor(100, 255, 255),
-                QColor(255, 150, 100), QColor(150, 100, 255)
-            };
-            pix.fill(colors[(i-1) % 8]);
-            QPainter painter(&pix);
-            painter.setPen(Qt::black);
-            painter.setFont(QFont("Arial", 20, QFont::Bold));
-            painter.drawText(pix.rect(), Qt::AlignCenter, QString::number(i));
+            // 如果图片加载失败，使用彩色占位符
+            pix = TileSet::placeholder(i, 50);
             qDebug() << "Failed to load image" << i << ", using placeholder. Tried paths:" << paths;
-        } else {
-            // 缩放图片到合适大小
-            pix = pix.scaled(50, 50, Qt::KeepAspectRatio, Qt::SmoothTransformation);
         }
-        imageCache.append(pix);
+        images.append(pix);
     }
+    tileSet.setImages(images);
     
-    qDebug() << "Loaded" << imageCache.size() << "images into cache";
+    qDebug() << "Loaded" << images.size() << "images into cache from" << basePath << "/" << workPath;
 }
 
 void GameBoard::setDifficulty(Difficulty d) {
@@ -114,9 +143,7 @@ void GameBoard::setDifficulty(Difficulty d) {
 }
 
 QPixmap GameBoard::getImageForValue(int value) {
-    if (value == 0 || value < 1 || value > 8) return QPixmap();
-    int imageIndex = ((value - 1) % 8);
-    return imageCache[imageIndex];
+    return tileSet.tile(value);
 }
 
 void GameBoard::updateButtonImage(QPushButton* btn, int value) {
@@ -186,6 +213,7 @@ void GameBoard::updateButtonImage(QPushButton* btn, int value) {
 }
 
 void GameBoard::drawConnectionLine(const QPoint& a, const QPoint& b) {
+    Telemetry::Scope telemetry(Telemetry::PAINT);
     if (connectionLine) {
         connectionLine->deleteLater();
         connectionLine = nullptr;
@@ -237,7 +265,8 @@ void GameBoard::drawConnectionLine(const QPoint& a, const QPoint& b) {
     
     connectionLine->setPixmap(linePix);
     connectionLine->show();
-    connectionTimer->start(300);
+    scheduler->cancel(connectionEvent);
+    connectionEvent = scheduler->schedule(300, this, [this]() { onConnectionAnimationFinished(); });
 }
 
 void GameBoard::onConnectionAnimationFinished() {
@@ -245,36 +274,85 @@ void GameBoard::onConnectionAnimationFinished() {
         connectionLine->deleteLater();
         connectionLine = nullptr;
     }
-    connectionTimer->stop();
+    connectionEvent = 0;
 }
 
+// 引擎立即消除并按规则移动，之后的点击、提示和自动求解都基于新棋盘；
+// 延迟的只有按钮刷新和滑动动画，其间的其他消除不会让本次消除作用到移动过来的图块上
 void GameBoard::removePair(const QPoint& a, const QPoint& b) {
-    drawConnectionLine(a, b);
+    drawConnectionLine(a, b); // 路径按消除前的棋盘计算
     emit pairMatched();
     
-    QTimer::singleShot(300, this, [=]() {
-        map[a.x()][a.y()] = 0;
-        map[b.x()][b.y()] = 0;
+    QVector<TileMove> moves = engine.removePair(a, b);
+    QVector<QPoint> vacated{a, b}, filled;
+    for (const TileMove& m : moves) {
+        vacated.append(m.from);
+        filled.append(m.to);
+    }
+    hints.update(engine, vacated, filled);
+    replay.recordMatch(a, b);
+    if (spectators) spectators->publishMatch(a, b);
+    markChanged();
+    countRemovedPair();
+    
+    pendingRemovals++;
+    scheduler->schedule(300, this, [=]() {
+        pendingRemovals--;
+        // 格子可能已被之后的移动填上，动画结束时目标格按引擎的当前值刷新
         updateButtonImage(buttons[a.x()][a.y()], 0);
         updateButtonImage(buttons[b.x()][b.y()], 0);
-        
-        pairsRemoved++;
-        
-        if (pairsRemoved % 5 == 0) {
-            emit bonusTime(10);
-        }
-        
-        int points = 10;
-        switch(difficulty) {
-            case BEGINNER: points = 5; break;
-            case PRIMARY: points = 10; break;
-            case INTERMEDIATE: points = 15; break;
-            case ADVANCED: points = 20; break;
-        }
-        emit pairRemoved(points);
+        animateMoves(moves);
     });
 }
 
+// 每消除5对奖励一次时间；撤销后再次消除同一对时pairsRemoved回到同一个值，不重复奖励
+void GameBoard::countRemovedPair() {
+    pairsRemoved++;
+    if (pairsRemoved % 5 == 0 && pairsRemoved > bonusPairs) {
+        bonusPairs = pairsRemoved;
+        emit bonusTime(10);
+    }
+    emit pairRemoved(BoardEngine::pointsFor(difficulty));
+}
+
+// 只为真正移动过的图块播放滑动动画：源格立即置空，目标格在动画结束后显示
+void GameBoard::animateMoves(const QVector<TileMove>& moves) {
+    if (moves.isEmpty()) return;
+    
+    // 选中的图块可能已被移走，取消选中
+    if (hasFirst) {
+        hasFirst = false;
+        updateButtonImage(firstBtn, engine.at(firstPos));
+    }
+    
+    for (const TileMove& m : moves) {
+        updateButtonImage(buttons[m.from.x()][m.from.y()], 0);
+    }
+    for (const TileMove& m : moves) {
+        QPushButton *src = buttons[m.from.x()][m.from.y()];
+        QPushButton *dst = buttons[m.to.x()][m.to.y()];
+        QLabel *sprite = new QLabel(this);
+        sprite->setAttribute(Qt::WA_TransparentForMouseEvents);
+        sprite->setAlignment(Qt::AlignCenter);
+        sprite->setPixmap(getImageForValue(m.value));
+        sprite->setGeometry(src->geometry());
+        sprite->show();
+        sprite->raise();
+        
+        QPropertyAnimation *anim = new QPropertyAnimation(sprite, "pos", sprite);
+        anim->setDuration(150);
+        anim->setStartValue(src->pos());
+        anim->setEndValue(dst->pos());
+        anim->setEasingCurve(QEasingCurve::OutQuad);
+        QPoint to = m.to;
+        connect(anim, &QPropertyAnimation::finished, this, [this, sprite, to]() {
+            updateButtonImage(buttons[to.x()][to.y()], engine.at(to));
+            sprite->deleteLater();
+        });
+        anim->start();
+    }
+}
+
 void GameBoard::setupButton(int i, int j, int value) {
     QPushButton *btn = new QPushButton(this);
     // 设置固定大小，确保布局稳定
@@ -286,7 +364,7 @@ void GameBoard::setupButton(int i, int j, int value) {
     buttons[i][j] = btn;
     
     connect(btn, &QPushButton::clicked, this, [=](){
-        if(map[i][j] == 0) return;
+        if(engine.at(i, j) == 0) return;
         
         if(!hasFirst) {
             firstBtn = btn; 
@@ -304,9 +382,9 @@ void GameBoard::setupButton(int i, int j, int value) {
                 return;
             }
             
-            if(map[firstPos.x()][firstPos.y()] == map[i][j]) {
+            if(engine.at(firstPos) == engine.at(i, j)) {
                 // 连接规则统一：所有难度都是最多2次转弯
-                if (canLink(firstPos, secondPos, 2)) {
+                if (engine.canLink(firstPos, secondPos, 2)) {
                     removePair(firstPos, secondPos);
                 } else {
                     hasFirst = false;
@@ -324,6 +402,25 @@ void GameBoard::generateSolvableMap() {
 }
 
 void GameBoard::generateMap() {
+    StartupTrace::Scope trace("generateSolvableMap"); // 只有启动时的第一次被记录
+    Telemetry::Scope telemetry(Telemetry::GENERATE);
+    // 先在局部布局上生成，完成后一次性交给引擎建立索引
+    int retries = 0;
+    QVector<QVector<int>> map = BoardEngine::generateLayout(rows, cols, difficulty, rng, &retries);
+    trace.setArg("verifyRetries", retries);
+    telemetry.setArg(retries);
+    engine.setMap(map);
+    hints.clear();
+    rebuildButtons();
+    replay.begin({gameSeed, rows, cols, difficulty, engine.getShiftRule(), BoardEngine::typeCountFor(rows, cols)});
+    if (spectators) spectators->publishSnapshot(engine);
+    
+    pairsRemoved = 0;
+    bonusPairs = 0;
+    markChanged();
+}
+
+void GameBoard::rebuildButtons() {
     if (!buttons.isEmpty()) {
         QLayoutItem *it;
         while((it = grid->takeAt(0))) {
@@ -334,428 +431,77 @@ void GameBoard::generateMap() {
         }
     }
     
-    map = QVector<QVector<int>>(rows, QVector<int>(cols, 0));
     buttons.resize(rows);
-    
-    int totalCells = rows * cols;
-    int pairCount = totalCells / 2;
-    int typeCount = qMin(pairCount, 8); // 最多8种图片
-    
-    QVector<int> values;
-    for(int i = 0; i < pairCount; i++) {
-        int v = (i % typeCount) + 1;
-        values.append(v);
-        values.append(v);
-    }
-    
-    // 根据难度生成不同布局
-    switch(difficulty) {
-        case BEGINNER: {
-            // 入门级：尽量相邻配对，保证直连多
-            // 每对图片都相邻放置，确保可以直接连接
-            int pairIdx = 0;
-            for(int i = 0; i < rows; i++) {
-                buttons[i].resize(cols);
-                for(int j = 0; j < cols; j += 2) {
-                    if (j + 1 < cols && pairIdx < pairCount) {
-                        int val = (pairIdx % typeCount) + 1;
-                        map[i][j] = val;
-                        map[i][j+1] = val; // 相邻配对，可以直连
-                        pairIdx++;
-                    }
-                }
-            }
-            // 如果cols是奇数，处理最后一列
-            if(cols % 2 == 1 && pairIdx < pairCount) {
-                // 最后一列与下一行配对
-                for(int i = 0; i < rows - 1 && pairIdx < pairCount; i += 2) {
-                    int val = (pairIdx % typeCount) + 1;
-                    map[i][cols-1] = val;
-                    map[i+1][cols-1] = val; // 同一列相邻，可以直连
-                    pairIdx++;
-                }
-            }
-            break;
-        }
-        
-        case PRIMARY: {
-            // 初级：生成较多一拐的配对
-            // 策略：让配对在同一行或同一列，但不相邻，这样可以一拐连接
-            std::shuffle(values.begin(), values.end(), *QRandomGenerator::global());
-            
-            int pairIdx = 0;
-            // 尽量在同一行放置配对，但不相邻
-            for(int i = 0; i < rows; i++) {
-                buttons[i].resize(cols);
-                QVector<int> colIndices;
-                for(int j = 0; j < cols; j++) {
-                    if(map[i][j] == 0) colIndices.append(j);
-                }
-                std::shuffle(colIndices.begin(), colIndices.end(), *QRandomGenerator::global());
-                
-                // 在同一行放置配对
-                for(int k = 0; k < colIndices.size() - 1 && pairIdx < pairCount; k += 2) {
-                    int val = (pairIdx % typeCount) + 1;
-                    map[i][colIndices[k]] = val;
-                    map[i][colIndices[k+1]] = val;
-                    pairIdx++;
-                }
-            }
-            
-            // 填充剩余的，尽量在同一列
-            for(int j = 0; j < cols && pairIdx < pairCount; j++) {
-                QVector<int> rowIndices;
-                for(int i = 0; i < rows; i++) {
-                    if(map[i][j] == 0) rowIndices.append(i);
-                }
-                for(int k = 0; k < rowIndices.size() - 1 && pairIdx < pairCount; k += 2) {
-                    int val = (pairIdx % typeCount) + 1;
-                    map[rowIndices[k]][j] = val;
-                    map[rowIndices[k+1]][j] = val;
-                    pairIdx++;
-                }
-            }
-            
-            // 最后填充剩余的
-            int valIdx = pairIdx * 2;
-            for(int i = 0; i < rows && valIdx < values.size(); i++) {
-                for(int j = 0; j < cols && valIdx < values.size(); j++) {
-                    if(map[i][j] == 0) {
-                        map[i][j] = values[valIdx++];
-                    }
-                }
-            }
-            break;
-        }
-        
-        case INTERMEDIATE: {
-            // 中级：生成较多两拐的配对
-            // 完全随机打乱
-            std::shuffle(values.begin(), values.end(), *QRandomGenerator::global());
-            
-            int idx = 0;
-            for(int i = 0; i < rows; i++) {
-                buttons[i].resize(cols);
-                for(int j = 0; j < cols; j++) {
-                    map[i][j] = values[idx++];
-                }
-            }
-            
-            // 验证并调整，确保有解
-            int attempts = 0;
-            while(!verifySolvabilityQuick() && attempts < 50) {
-                // 重新打乱
-                std::shuffle(values.begin(), values.end(), *QRandomGenerator::global());
-                idx = 0;
-                for(int i = 0; i < rows; i++) {
-                    for(int j = 0; j < cols; j++) {
-                        map[i][j] = values[idx++];
-                    }
-                }
-                attempts++;
-            }
-            break;
-        }
-        
-        case ADVANCED: {
-            // 高级：完全随机，难度最高
-            std::shuffle(values.begin(), values.end(), *QRandomGenerator::global());
-            
-            int idx = 0;
-            for(int i = 0; i < rows; i++) {
-                buttons[i].resize(cols);
-                for(int j = 0; j < cols; j++) {
-                    map[i][j] = values[idx++];
-                }
-            }
-            
-            // 多次尝试，找到有解的布局
-            int attempts = 0;
-            while(!verifySolvabilityQuick() && attempts < 200) {
-                std::shuffle(values.begin(), values.end(), *QRandomGenerator::global());
-                idx = 0;
-                for(int i = 0; i < rows; i++) {
-                    for(int j = 0; j < cols; j++) {
-                        map[i][j] = values[idx++];
-                    }
-                }
-                attempts++;
-            }
-            break;
-        }
-    }
-    
-    // 创建按钮
     for(int i = 0; i < rows; i++) {
+        buttons[i].resize(cols);
         for(int j = 0; j < cols; j++) {
-            setupButton(i, j, map[i][j]);
+            setupButton(i, j, engine.at(i, j));
         }
     }
-    
-    pairsRemoved = 0;
 }
 
-// 快速验证可解性（简化版）
-bool GameBoard::verifySolvabilityQuick() {
-    QVector<QVector<int>> tempMap = map;
-    
-    // 尝试消除所有配对
-    int eliminated = 0;
-    while(eliminated < rows * cols) {
-        bool found = false;
-        QPoint a, b;
-        
-        for(int i = 0; i < rows && !found; i++) {
-            for(int j = 0; j < cols && !found; j++) {
-                if(tempMap[i][j] == 0) continue;
-                for(int x = i; x < rows && !found; x++) {
-                    for(int y = 0; y < cols && !found; y++) {
-                        if((i == x && j == y) || tempMap[x][y] == 0) continue;
-                        if(tempMap[i][j] == tempMap[x][y]) {
-                            int maxTurns = 2;
-                            if(canLinkInternal(tempMap, QPoint(i,j), QPoint(x,y), maxTurns)) {
-                                a = QPoint(i, j);
-                                b = QPoint(x, y);
-                                found = true;
-                            }
-                        }
-                    }
-                }
-            }
-        }
-        
-        if(!found) break;
-        
-        tempMap[a.x()][a.y()] = 0;
-        tempMap[b.x()][b.y()] = 0;
-        eliminated += 2;
-    }
-    
-    return eliminated == rows * cols;
-}
-
-// canLink的内部版本，使用临时地图
-bool GameBoard::canLinkInternal(const QVector<QVector<int>>& tempMap, const QPoint& a, const QPoint& b, int maxTurns) {
-    // 直连
-    if(a.x() == b.x()) {
-        int minC = qMin(a.y(), b.y());
-        int maxC = qMax(a.y(), b.y());
-        bool clear = true;
-        for(int c = minC + 1; c < maxC; c++) {
-            if(tempMap[a.x()][c] != 0) { clear = false; break; }
-        }
-        if(clear) return true;
-    }
-    if(a.y() == b.y()) {
-        int minR = qMin(a.x(), b.x());
-        int maxR = qMax(a.x(), b.x());
-        bool clear = true;
-        for(int r = minR + 1; r < maxR; r++) {
-            if(tempMap[r][a.y()] != 0) { clear = false; break; }
-        }
-        if(clear) return true;
-    }
-    
-    if(maxTurns < 1) return false;
-    
-    // 一拐
-    QPoint corner1(a.x(), b.y());
-    if(corner1 != a && corner1 != b && tempMap[corner1.x()][corner1.y()] == 0) {
-        bool hClear = true, vClear = true;
-        int minC = qMin(a.y(), b.y());
-        int maxC = qMax(a.y(), b.y());
-        for(int c = minC + 1; c < maxC; c++) {
-            if(tempMap[a.x()][c] != 0) { hClear = false; break; }
-        }
-        int minR = qMin(a.x(), b.x());
-        int maxR = qMax(a.x(), b.x());
-        for(int r = minR + 1; r < maxR; r++) {
-            if(tempMap[r][b.y()] != 0) { vClear = false; break; }
-        }
-        if(hClear && vClear) return true;
-    }
-    
-    QPoint corner2(b.x(), a.y());
-    if(corner2 != a && corner2 != b && tempMap[corner2.x()][corner2.y()] == 0) {
-        bool vClear = true, hClear = true;
-        int minR = qMin(a.x(), b.x());
-        int maxR = qMax(a.x(), b.x());
-        for(int r = minR + 1; r < maxR; r++) {
-            if(tempMap[r][a.y()] != 0) { vClear = false; break; }
-        }
-        int minC = qMin(a.y(), b.y());
-        int maxC = qMax(a.y(), b.y());
-        for(int c = minC + 1; c < maxC; c++) {
-            if(tempMap[b.x()][c] != 0) { hClear = false; break; }
-        }
-        if(vClear && hClear) return true;
-    }
-    
-    if(maxTurns < 2) return false;
-    
-    // 两拐
-    for(int i = 0; i < rows; i++) {
-        QPoint p1(i, a.y());
-        QPoint p2(i, b.y());
-        if(p1 != a && p1 != b && p2 != a && p2 != b && 
-           tempMap[p1.x()][p1.y()] == 0 && tempMap[p2.x()][p2.y()] == 0) {
-            // 检查三条线段
-            bool ok = true;
-            int minR = qMin(a.x(), i);
-            int maxR = qMax(a.x(), i);
-            for(int r = minR + 1; r < maxR; r++) {
-                if(tempMap[r][a.y()] != 0) { ok = false; break; }
-            }
-            if(ok) {
-                int minC = qMin(a.y(), b.y());
-                int maxC = qMax(a.y(), b.y());
-                for(int c = minC + 1; c < maxC; c++) {
-                    if(tempMap[i][c] != 0) { ok = false; break; }
-                }
-            }
-            if(ok) {
-                minR = qMin(i, b.x());
-                maxR = qMax(i, b.x());
-                for(int r = minR + 1; r < maxR; r++) {
-                    if(tempMap[r][b.y()] != 0) { ok = false; break; }
-                }
-            }
-            if(ok) return true;
-        }
-    }
-    
-    for(int j = 0; j < cols; j++) {
-        QPoint p1(a.x(), j);
-        QPoint p2(b.x(), j);
-        if(p1 != a && p1 != b && p2 != a && p2 != b && 
-           tempMap[p1.x()][p1.y()] == 0 && tempMap[p2.x()][p2.y()] == 0) {
-            bool ok = true;
-            int minC = qMin(a.y(), j);
-            int maxC = qMax(a.y(), j);
-            for(int c = minC + 1; c < maxC; c++) {
-                if(tempMap[a.x()][c] != 0) { ok = false; break; }
-            }
-            if(ok) {
-                int minR = qMin(a.x(), b.x());
-                int maxR = qMax(a.x(), b.x());
-                for(int r = minR + 1; r < maxR; r++) {
-                    if(tempMap[r][j] != 0) { ok = false; break; }
-                }
-            }
-            if(ok) {
-                minC = qMin(j, b.y());
-                maxC = qMax(j, b.y());
-                for(int c = minC + 1; c < maxC; c++) {
-                    if(tempMap[b.x()][c] != 0) { ok = false; break; }
-                }
-            }
-            if(ok) return true;
-        }
-    }
-    
-    return false;
+bool GameBoard::restoreState(int r, int c, const QByteArray& tiles, int tileBytes, int removed,
+                             const GameRng::State& rngState) {
+    if (r != rows || c != cols) return false;
+    BoardEngine restored;
+    if (!restored.setPacked(r, c, tiles, tileBytes)) return false;
+    restored.setShiftRule(engine.getShiftRule());
+    restored.setHistoryLimit(engine.historyLimit());
+    scheduler->cancelAll(); // 丢弃尚未执行的消除和求解步骤
+    pendingRemovals = 0;
+    solvePending = false;
+    onConnectionAnimationFinished();
+    hasFirst = false;
+    clearHighlight();
+    engine = restored;
+    hints.clear();
+    rebuildButtons();
+    pairsRemoved = removed;
+    bonusPairs = removed; // 存档前的奖励都已发放
+    rng.setState(rngState);
+    replay.stop(); // 存档不含之前的操作，这一局不再录制
+    if (spectators) spectators->publishSnapshot(engine);
+    markChanged();
+    return true;
 }
 
-bool GameBoard::lineClearRow(int r, int c1, int c2) {
-    int minC = qMin(c1, c2);
-    int maxC = qMax(c1, c2);
-    for(int c = minC + 1; c < maxC; c++) {
-        if(map[r][c] != 0) return false;
-    }
-    return true;
+void GameBoard::setSpectatorFeed(SpectatorFeed* feed) {
+    spectators = feed;
+    if (spectators) spectators->publishSnapshot(engine);
 }
 
-bool GameBoard::lineClearCol(int c, int r1, int r2) {
-    int minR = qMin(r1, r2);
-    int maxR = qMax(r1, r2);
-    for(int r = minR + 1; r < maxR; r++) {
-        if(map[r][c] != 0) return false;
+void GameBoard::requestHint() {
+    // 缓存中的对仍然有效时直接返回，否则才到工作线程上全盘查找
+    QPoint a, b;
+    if (hints.peek(a, b)) {
+        Telemetry::record(Telemetry::HINT_LATENCY, 0, 1);
+        emit hintReady(true, a, b);
+        return;
     }
-    return true;
+    hintRequestUs = Telemetry::enabled() ? Telemetry::nowUs() : 0;
+    analyzer->requestHint(engine.snapshot(), boardRevision);
 }
 
-bool GameBoard::canLink(const QPoint& a, const QPoint& b, int maxTurns) {
-    if(maxTurns == -1) {
-        maxTurns = 2;
-    }
-    
-    // 直连
-    if(a.x() == b.x() && lineClearRow(a.x(), a.y(), b.y())) {
-        return true;
-    }
-    if(a.y() == b.y() && lineClearCol(a.y(), a.x(), b.x())) {
-        return true;
-    }
-    
-    if(maxTurns < 1) return false;
-    
-    // 一拐：先横后竖
-    QPoint corner1(a.x(), b.y());
-    if(corner1 != a && corner1 != b && map[corner1.x()][corner1.y()] == 0) {
-        if(lineClearRow(a.x(), a.y(), b.y()) && lineClearCol(b.y(), a.x(), b.x())) {
-            return true;
-        }
-    }
-    
-    // 一拐：先竖后横
-    QPoint corner2(b.x(), a.y());
-    if(corner2 != a && corner2 != b && map[corner2.x()][corner2.y()] == 0) {
-        if(lineClearCol(a.y(), a.x(), b.x()) && lineClearRow(b.x(), a.y(), b.y())) {
-            return true;
-        }
-    }
-    
-    if(maxTurns < 2) return false;
-    
-    // 两拐：竖-横-竖
-    for(int i = 0; i < rows; i++) {
-        QPoint p1(i, a.y());
-        QPoint p2(i, b.y());
-        if(p1 != a && p1 != b && p2 != a && p2 != b && 
-           map[p1.x()][p1.y()] == 0 && map[p2.x()][p2.y()] == 0) {
-            if(lineClearCol(a.y(), a.x(), i) && 
-               lineClearRow(i, a.y(), b.y()) && 
-               lineClearCol(b.y(), i, b.x())) {
-                return true;
-            }
-        }
-    }
-    
-    // 两拐：横-竖-横
-    for(int j = 0; j < cols; j++) {
-        QPoint p1(a.x(), j);
-        QPoint p2(b.x(), j);
-        if(p1 != a && p1 != b && p2 != a && p2 != b && 
-           map[p1.x()][p1.y()] == 0 && map[p2.x()][p2.y()] == 0) {
-            if(lineClearRow(a.x(), a.y(), j) && 
-               lineClearCol(j, a.x(), b.x()) && 
-               lineClearRow(b.x(), j, b.y())) {
-                return true;
-            }
-        }
+void GameBoard::requestStuckCheck() {
+    if (!stuckCacheValid && !hints.isEmpty()) cacheStuck(false);
+    if (stuckCacheValid) {
+        emit stuckChecked(stuckCache);
+        return;
     }
-    
-    return false;
+    stuckRequestUs = Telemetry::enabled() ? Telemetry::nowUs() : 0;
+    analyzer->requestStuckCheck(engine.snapshot(), boardRevision);
 }
 
-bool GameBoard::findHint(QPoint& a, QPoint& b) {
-    // 连接规则统一：所有难度都是最多2次转弯
-    for(int i = 0; i < rows; i++) {
-        for(int j = 0; j < cols; j++) {
-            if(map[i][j] == 0) continue;
-            for(int x = i; x < rows; x++) {
-                for(int y = 0; y < cols; y++) {
-                    if((i == x && j == y) || map[x][y] == 0) continue;
-                    if(map[i][j] == map[x][y] && canLink(QPoint(i,j), QPoint(x,y), 2)) {
-                        a = QPoint(i, j);
-                        b = QPoint(x, y);
-                        return true;
-                    }
-                }
-            }
-        }
-    }
-    return false;
+void GameBoard::cacheStuck(bool stuck) {
+    stuckCache = stuck;
+    stuckCacheValid = true;
+}
+
+void GameBoard::markChanged() {
+    boardRevision++;
+    stuckCacheValid = false;
+    analyzer->invalidate(boardRevision);
+    emit boardChanged();
 }
 
 void GameBoard::highlight(const QPoint& a, const QPoint& b) {
@@ -766,204 +512,122 @@ void GameBoard::highlight(const QPoint& a, const QPoint& b) {
 void GameBoard::clearHighlight() {
     for(int i = 0; i < rows; i++) {
         for(int j = 0; j < cols; j++) {
-            if(map[i][j] != 0) {
-                updateButtonImage(buttons[i][j], map[i][j]);
+            if(engine.at(i, j) != 0) {
+                updateButtonImage(buttons[i][j], engine.at(i, j));
             }
         }
     }
 }
 
-bool GameBoard::hasSolvablePairs() {
-    QPoint a, b;
-    return findHint(a, b);
-}
-
-bool GameBoard::isStuck() {
-    return !hasSolvablePairs();
-}
-
 int GameBoard::getRemainingCount() const {
-    int count = 0;
-    for(int i = 0; i < rows; i++) {
-        for(int j = 0; j < cols; j++) {
-            if(map[i][j] != 0) count++;
-        }
-    }
-    return count;
+    return engine.remainingCount();
 }
 
 QVector<QPoint> GameBoard::findPath(const QPoint& a, const QPoint& b) {
     // 连接规则统一：所有难度都是最多2次转弯
-    return findPathInternal(a, b, 2);
-}
-
-QVector<QPoint> GameBoard::findPathInternal(const QPoint& a, const QPoint& b, int maxDepth) {
-    QVector<QPoint> path;
-    path.append(a);
-    
-    // 直连
-    if(a.x() == b.x() && lineClearRow(a.x(), a.y(), b.y())) {
-        path.append(b);
-        return path;
-    }
-    if(a.y() == b.y() && lineClearCol(a.y(), a.x(), b.x())) {
-        path.append(b);
-        return path;
-    }
-    
-    // 一拐
-    if(maxDepth >= 1) {
-        QPoint corner1(a.x(), b.y());
-        if(corner1 != a && corner1 != b && map[corner1.x()][corner1.y()] == 0) {
-            if(lineClearRow(a.x(), a.y(), b.y()) && lineClearCol(b.y(), a.x(), b.x())) {
-                path.append(corner1);
-                path.append(b);
-                return path;
-            }
-        }
-        
-        QPoint corner2(b.x(), a.y());
-        if(corner2 != a && corner2 != b && map[corner2.x()][corner2.y()] == 0) {
-            if(lineClearCol(a.y(), a.x(), b.x()) && lineClearRow(b.x(), a.y(), b.y())) {
-                path.append(corner2);
-                path.append(b);
-                return path;
-            }
-        }
-    }
-    
-    // 两拐
-    if(maxDepth >= 2) {
-        for(int i = 0; i < rows; i++) {
-            QPoint p1(i, a.y());
-            QPoint p2(i, b.y());
-            if(p1 != a && p1 != b && p2 != a && p2 != b && 
-               map[p1.x()][p1.y()] == 0 && map[p2.x()][p2.y()] == 0) {
-                if(lineClearCol(a.y(), a.x(), i) && 
-                   lineClearRow(i, a.y(), b.y()) && 
-                   lineClearCol(b.y(), i, b.x())) {
-                    path.append(p1);
-                    path.append(p2);
-                    path.append(b);
-                    return path;
-                }
-            }
-        }
-        
-        for(int j = 0; j < cols; j++) {
-            QPoint p1(a.x(), j);
-            QPoint p2(b.x(), j);
-            if(p1 != a && p1 != b && p2 != a && p2 != b && 
-               map[p1.x()][p1.y()] == 0 && map[p2.x()][p2.y()] == 0) {
-                if(lineClearRow(a.x(), a.y(), j) && 
-                   lineClearCol(j, a.x(), b.x()) && 
-                   lineClearRow(b.x(), j, b.y())) {
-                    path.append(p1);
-                    path.append(p2);
-                    path.append(b);
-                    return path;
-                }
-            }
-        }
-    }
-    
-    return path;
+    return engine.findPathInternal(a, b, 2);
 }
 
 void GameBoard::resetBoard(bool onlyRemaining) {
     if (onlyRemaining) {
         resetRemaining();
     } else {
-        hasFirst = false;
-        clearHighlight();
-        generateSolvableMap();
+        newGame(QRandomGenerator::global()->generate64());
     }
 }
 
+void GameBoard::newGame(quint64 seed) {
+    gameSeed = seed;
+    rng.reseed(seed);
+    scheduler->cancelAll(); // 上一局尚未执行的消除和求解步骤
+    pendingRemovals = 0;
+    solvePending = false;
+    onConnectionAnimationFinished();
+    hasFirst = false;
+    clearHighlight();
+    generateSolvableMap();
+}
+
 void GameBoard::resetRemaining() {
-    QVector<QPoint> remaining;
-    QVector<int> values;
-    
-    for(int i = 0; i < rows; i++) {
-        for(int j = 0; j < cols; j++) {
-            if(map[i][j] != 0) {
-                remaining.append(QPoint(i, j));
-                values.append(map[i][j]);
-            }
-        }
-    }
-    
-    std::shuffle(values.begin(), values.end(), *QRandomGenerator::global());
-    
-    for(int idx = 0; idx < remaining.size(); idx++) {
-        QPoint pos = remaining[idx];
-        map[pos.x()][pos.y()] = values[idx];
-        updateButtonImage(buttons[pos.x()][pos.y()], values[idx]);
+    replay.recordReshuffle();
+    QVector<int> permutation;
+    hints.clear();
+    for (const QPoint& pos : engine.shuffleRemaining(rng, &permutation)) {
+        updateButtonImage(buttons[pos.x()][pos.y()], engine.at(pos));
     }
+    if (spectators) spectators->publishReshuffle(permutation);
     
     hasFirst = false;
     clearHighlight();
     pairsRemoved = 0;
+    bonusPairs = 0;
+    markChanged();
 }
 
-// 改进的自动解题：递归方式，每次消除后重新查找
-void GameBoard::solveAutomatically() {
-    solvingPairs.clear();
-    solveStepIndex = 0;
-    
-    // 开始递归求解
-    solveNextPair();
+bool GameBoard::undoMove() {
+    return stepHistory(false);
 }
 
-void GameBoard::solveNextPair() {
-    // 查找当前可消除的对
-    QPoint a, b;
-    bool found = false;
+bool GameBoard::redoMove() {
+    return stepHistory(true);
+}
+
+// 引擎按记录只改动涉及的格子，这里只刷新这些按钮
+bool GameBoard::stepHistory(bool forward) {
+    if (connectionEvent || pendingRemovals > 0) return false; // 还有未刷新完的消除
+    QVector<QPoint> changed;
+    BoardEngine::MoveRecord record;
+    if (!(forward ? engine.redo(&changed, &record) : engine.undo(&changed, &record))) return false;
+    for (const QPoint& pos : changed) {
+        updateButtonImage(buttons[pos.x()][pos.y()], engine.at(pos));
+    }
+    hints.clear();
+    replay.stop(); // 回放格式不含撤销，这一局不再录制
+    if (spectators) spectators->publishSnapshot(engine);
     
-    // 连接规则统一：所有难度都是最多2次转弯
-    for(int i = 0; i < rows && !found; i++) {
-        for(int j = 0; j < cols && !found; j++) {
-            if(map[i][j] == 0) continue;
-            for(int x = i; x < rows && !found; x++) {
-                for(int y = 0; y < cols && !found; y++) {
-                    if((i == x && j == y) || map[x][y] == 0) continue;
-                    if(map[i][j] == map[x][y] && canLink(QPoint(i,j), QPoint(x,y), 2)) {
-                        a = QPoint(i, j);
-                        b = QPoint(x, y);
-                        found = true;
-                    }
-                }
-            }
+    hasFirst = false;
+    clearHighlight();
+    markChanged();
+    
+    if (!record.shuffle) {
+        if (forward) {
+            pairsRemoved++;
+            emit pairRemoved(BoardEngine::pointsFor(difficulty));
+        } else {
+            pairsRemoved = qMax(0, pairsRemoved - 1);
+            emit pairRestored(BoardEngine::pointsFor(difficulty));
         }
     }
+    return true;
+}
+
+// 改进的自动解题：每次消除后重新查找
+void GameBoard::solveAutomatically() {
+    solveNextPair();
+}
+
+void GameBoard::solveNextPair() {
+    // 查找当前可消除的对，结果由onSolveHint处理
+    solvePending = true;
+    requestHint();
+}
+
+void GameBoard::onSolveHint(bool found, const QPoint& a, const QPoint& b) {
+    if (!solvePending) return;
+    solvePending = false;
     
     if (found) {
         highlight(a, b);
         
         // 延迟消除
-        QTimer::singleShot(500, this, [=]() {
-            if(map[a.x()][a.y()] != 0 && map[b.x()][b.y()] != 0 &&
-               map[a.x()][a.y()] == map[b.x()][b.y()]) {
+        scheduler->schedule(500, this, [=]() {
+            if(engine.at(a) != 0 && engine.at(a) == engine.at(b) && engine.canLink(a, b, 2)) {
                 removePair(a, b);
                 
-                pairsRemoved++;
-                int points = 10;
-                switch(difficulty) {
-                    case BEGINNER: points = 5; break;
-                    case PRIMARY: points = 10; break;
-                    case INTERMEDIATE: points = 15; break;
-                    case ADVANCED: points = 20; break;
-                }
-                emit pairRemoved(points);
-                
-                if (pairsRemoved % 5 == 0) {
-                    emit bonusTime(10);
-                }
-                
                 // 继续下一对
-                QTimer::singleShot(400, this, &GameBoard::solveNextPair);
+                scheduler->schedule(400, this, [this]() { solveNextPair(); });
             } else {
-                // 如果这对已被消除，继续查找
+                // 这对已被消除或不再相连，重新查找
                 solveNextPair();
             }
         });
@@ -10,13 +10,15 @@
 #include <QGraphicsOpacityEffect>
 #include <QLabel>
 #include <QPixmap>
+#include "boardanalyzer.h"
+#include "boardengine.h"
+#include "gamerng.h"
+#include "replaylog.h"
+#include "hintcache.h"
+#include "gamescheduler.h"
+#include "tileset.h"
 
-enum Difficulty {
-    BEGINNER,    // 入门级：直连比例高
-    PRIMARY,     // 初级：拐一个弯比例高
-    INTERMEDIATE,// 中级：拐2个弯比例高
-    ADVANCED     // 高级：最多3个弯
-};
+class SpectatorFeed;
 
 class GameBoard : public QWidget{
     Q_OBJECT
@@ -24,24 +26,46 @@ public:
     explicit GameBoard(int r,int c,QWidget *parent=nullptr);
     ~GameBoard();
     void resetBoard(bool onlyRemaining=false);
+    void newGame(quint64 seed); // 同一种子与参数生成相同的布局和重排序列
+    quint64 getSeed() const { return gameSeed; }
     void resetRemaining();
-    bool findHint(QPoint &a,QPoint &b);
     void highlight(const QPoint &a,const QPoint &b);
     void clearHighlight();
-    bool hasSolvablePairs();
-    bool isStuck();
     void solveAutomatically();
-    void solveNextPair(); // 递归求解下一对
+    void solveNextPair(); // 在工作线程上查找下一对，结果到达后延迟消除并继续
     void setDifficulty(Difficulty d);
     Difficulty getDifficulty() const { return difficulty; }
+    void setShiftRule(ShiftRule rule) { engine.setShiftRule(rule); }
+    ShiftRule getShiftRule() const { return engine.getShiftRule(); }
     int getRemainingCount() const;
     QVector<QPoint> findPath(const QPoint& a, const QPoint& b);
     void drawConnectionLine(const QPoint& a, const QPoint& b);
+    quint64 getRevision() const { return boardRevision; }
+    GameScheduler* getScheduler() const { return scheduler; } // 暂停时整个调度器一起暂停
+    const BoardEngine& boardEngine() const { return engine; } // 存档直接引用紧凑地图，不展开
+    int getPairsRemoved() const { return pairsRemoved; }
+    const GameRng::State& rngState() const { return rng.state(); }
+    bool restoreState(int r, int c, const QByteArray& tiles, int tileBytes, int pairsRemoved,
+                      const GameRng::State& rngState);
+    void requestHint();       // 异步查找提示，结果通过hintReady返回
+    void requestStuckCheck(); // 异步检查僵局，结果通过stuckChecked返回；同一版本只计算一次
+    void recordHint() { replay.recordHint(); } // 提示被使用时记入回放
+    bool saveReplay(const QString& path) { return replay.save(path); }
+    void setSpectatorFeed(SpectatorFeed* feed); // 设置后立即发送当前棋盘快照
+    // 撤销/重做上一步消除或重排；消除的按钮刷新尚未完成时返回false
+    bool undoMove();
+    bool redoMove();
+    bool canUndo() const { return engine.canUndo(); }
+    bool canRedo() const { return engine.canRedo(); }
     
 signals:
     void pairRemoved(int points);
+    void pairRestored(int points); // 撤销了一次消除，应扣回的分数
     void bonusTime(int seconds);
     void pairMatched(); // 配对成功信号，用于播放音效
+    void boardChanged(); // 棋盘内容发生变化（消除、重排、新局）
+    void hintReady(bool found, const QPoint& a, const QPoint& b);
+    void stuckChecked(bool stuck);
     
 private slots:
     void onAnimationFinished();
@@ -50,34 +74,48 @@ private slots:
 private:
     int rows,cols;
     QGridLayout *grid;
-    QVector<QVector<int>> map;
+    BoardEngine engine; // 地图、索引与规则
+    static const int HISTORY_LIMIT = 64; // 撤销历史最多保留的步数
     QVector<QVector<QPushButton*>> buttons;
     QPushButton *firstBtn;
     QPoint firstPos;
     bool hasFirst;
     Difficulty difficulty;
-    QVector<QPair<QPoint, QPoint>> solvingPairs; // 存储配对，而不是路径
-    QTimer *solveTimer;
-    int solveStepIndex;
+    bool solvePending; // 自动求解正在等待后台提示结果
     int pairsRemoved;
-    QVector<QPixmap> imageCache; // 缓存加载的图片
+    int bonusPairs; // 已发放奖励时间时的最大消除数
+    TileSet tileSet; // 图块图片，按值缓存缩放后的结果
     QLabel *connectionLine; // 用于显示连线
-    QTimer *connectionTimer;
+    GameScheduler *scheduler; // 延迟消除、连线消失和自动求解都经由它定时
+    GameScheduler::EventId connectionEvent;
+    int pendingRemovals; // 引擎已消除、按钮尚未刷新的对数，期间不允许撤销
+    qint64 hintRequestUs;  // 遥测：后台查找开始的时间，0表示未在计时
+    qint64 stuckRequestUs;
+    quint64 boardRevision; // 每次修改棋盘递增，用于丢弃过期的后台分析
+    BoardAnalyzer *analyzer;
+    bool stuckCacheValid; // stuckCache对应当前boardRevision
+    bool stuckCache;
+    HintCache hints; // 提示、僵局检测与自动求解共用
+    quint64 gameSeed;
+    GameRng rng; // 布局与重排使用的随机数，状态随存档保存
+    ReplayRecorder replay;
+    SpectatorFeed *spectators;
     
     void generateMap();
-    bool canLink(const QPoint&a,const QPoint&b, int maxTurns = -1);
-    bool lineClearRow(int r,int c1,int c2);
-    bool lineClearCol(int c,int r1,int r2);
+    void rebuildButtons(); // 按引擎中的地图重建全部按钮
     void setupButton(int i, int j, int value);
     QPixmap getImageForValue(int value);
     void updateButtonImage(QPushButton* btn, int value);
-    QVector<QPoint> findPathInternal(const QPoint& a, const QPoint& b, int maxDepth);
     bool verifySolvability();
-    bool verifySolvabilityQuick(); // 快速验证
-    bool canLinkInternal(const QVector<QVector<int>>& tempMap, const QPoint& a, const QPoint& b, int maxTurns);
     void generateSolvableMap();
     void loadImages();
     void removePair(const QPoint& a, const QPoint& b);
+    void animateMoves(const QVector<TileMove>& moves);
+    bool stepHistory(bool forward);
+    void countRemovedPair(); // 计数、奖励时间并发出pairRemoved
+    void onSolveHint(bool found, const QPoint& a, const QPoint& b);
+    void markChanged();
+    void cacheStuck(bool stuck);
 };
 
 #endif
@@ -0,0 +1,82 @@
+#include "gamebot.h"
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QDebug>
+
+GameBot::GameBot(const QString& name, const QString& seed, QObject* parent)
+    : QObject(parent), name(name), seed(seed), session(0), games(0)
+{
+    socket = new QTcpSocket(this);
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    connect(socket, &QTcpSocket::connected, this, &GameBot::join);
+    connect(socket, &QTcpSocket::readyRead, this, &GameBot::onReadyRead);
+}
+
+void GameBot::connectTo(quint16 port, const QHostAddress& host) {
+    socket->connectToHost(host, port);
+}
+
+void GameBot::send(const QJsonObject& request) {
+    socket->write(QJsonDocument(request).toJson(QJsonDocument::Compact) + '\n');
+}
+
+void GameBot::join() {
+    send({{"op", "join"}, {"player", name}, {"seed", seed}});
+}
+
+void GameBot::onReadyRead() {
+    while (socket->canReadLine()) {
+        QJsonDocument doc = QJsonDocument::fromJson(socket->readLine());
+        if (doc.isObject()) handle(doc.object());
+    }
+}
+
+void GameBot::loadCells(const QJsonObject& reply) {
+    int rows = reply.value("rows").toInt(board.rowCount());
+    int cols = reply.value("cols").toInt(board.colCount());
+    QJsonArray cells = reply.value("cells").toArray();
+    QVector<QVector<int>> map(rows, QVector<int>(cols, 0));
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) map[i][j] = cells.at(i * cols + j).toInt();
+    }
+    board.setMap(map);
+}
+
+void GameBot::handle(const QJsonObject& reply) {
+    QString op = reply.value("op").toString();
+    if (!reply.value("ok").toBool()) {
+        qDebug() << name << op << "rejected:" << reply.value("error").toString();
+        // 加入失败时停止；其他失败说明本地棋盘与服务器不一致，放弃这一局重新加入
+        if (op == "leave") join();
+        else if (op != "join") send({{"op", "leave"}, {"session", session}});
+        return;
+    }
+    if (op == "join") {
+        session = reply.value("session").toInteger();
+        loadCells(reply);
+    } else if (op == "shuffle") {
+        loadCells(reply);
+    } else if (op == "move") {
+        board.removePair(pendingA, pendingB);
+        if (reply.value("remaining").toInt() == 0) {
+            games++;
+            emit gameFinished(reply.value("score").toInt());
+            send({{"op", "leave"}, {"session", session}});
+            return;
+        }
+    } else if (op == "leave") {
+        join();
+        return;
+    }
+    playNext();
+}
+
+void GameBot::playNext() {
+    if (board.findHint(pendingA, pendingB)) {
+        const int cols = board.colCount();
+        send({{"op", "move"}, {"session", session},
+              {"a", pendingA.x() * cols + pendingA.y()}, {"b", pendingB.x() * cols + pendingB.y()}});
+    } else {
+        send({{"op", "shuffle"}, {"session", session}});
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef GAMEBOT_H
+#define GAMEBOT_H
+#include <QObject>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QJsonObject>
+#include "boardengine.h"
+
+// 压测用的机器人客户端：加入一局后按提示逐对消除，无解时请求重排，
+// 一局结束后用同一种子重新加入。本地维护一份棋盘，只用服务器的响应确认每一步。
+class GameBot : public QObject {
+    Q_OBJECT
+public:
+    GameBot(const QString& name, const QString& seed, QObject* parent = nullptr);
+
+    void connectTo(quint16 port, const QHostAddress& host = QHostAddress::LocalHost);
+    int gamesFinished() const { return games; }
+
+signals:
+    void gameFinished(int score);
+
+private:
+    QTcpSocket* socket;
+    QString name;
+    QString seed;
+    qint64 session;
+    BoardEngine board;
+    QPoint pendingA;
+    QPoint pendingB;
+    int games;
+
+    void onReadyRead();
+    void handle(const QJsonObject& reply);
+    void join();
+    void playNext();
+    void send(const QJsonObject& request);
+    void loadCells(const QJsonObject& reply);
+};
+
+#endif
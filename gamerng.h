@@ -0,0 +1,50 @@
+#ifndef GAMERNG_H
+#define GAMERNG_H
+#include <QtGlobal>
+#include <array>
+
+// 可设种子、状态可保存的随机数生成器（xoshiro256**）。
+// 满足UniformRandomBitGenerator，可直接传给std::shuffle；状态只有32字节，随存档一起保存。
+class GameRng {
+public:
+    typedef quint64 result_type;
+    typedef std::array<quint64, 4> State;
+
+    explicit GameRng(quint64 seed = 0) { reseed(seed); }
+
+    // 用splitmix64把64位种子展开为完整状态
+    void reseed(quint64 seed) {
+        for (quint64& word : s) {
+            seed += 0x9E3779B97F4A7C15ull;
+            quint64 z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    const State& state() const { return s; }
+    void setState(const State& state) { s = state; }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~quint64(0); }
+
+    result_type operator()() {
+        quint64 result = rotl(s[1] * 5, 7) * 9;
+        quint64 t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+private:
+    State s;
+
+    static quint64 rotl(quint64 x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+#endif
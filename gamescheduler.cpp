@@ -0,0 +1,110 @@
+#include "gamescheduler.h"
+#include <cmath>
+#include <climits>
+
+GameScheduler::GameScheduler(QObject *parent)
+    : QObject(parent), gameBase(0), clockBase(0), timeScale(1.0), paused(false), nextId(1)
+{
+    clock.start();
+    timer = new QTimer(this);
+    timer->setSingleShot(true);
+    timer->setTimerType(Qt::PreciseTimer);
+    connect(timer, &QTimer::timeout, this, &GameScheduler::onTick);
+}
+
+qint64 GameScheduler::now() const {
+    if (paused) return gameBase;
+    return gameBase + qint64((clock.elapsed() - clockBase) * timeScale);
+}
+
+void GameScheduler::rebase() {
+    gameBase = now();
+    clockBase = clock.elapsed();
+}
+
+GameScheduler::EventId GameScheduler::schedule(qint64 delayMs, QObject *context, std::function<void()> fn) {
+    EventId id = nextId++;
+    events.append({id, now() + qMax<qint64>(0, delayMs), 0, context, std::move(fn)});
+    arm();
+    return id;
+}
+
+GameScheduler::EventId GameScheduler::scheduleRepeating(qint64 intervalMs, QObject *context, std::function<void()> fn) {
+    EventId id = nextId++;
+    intervalMs = qMax<qint64>(1, intervalMs);
+    events.append({id, now() + intervalMs, intervalMs, context, std::move(fn)});
+    arm();
+    return id;
+}
+
+void GameScheduler::cancel(EventId id) {
+    for (int i = 0; i < events.size(); i++) {
+        if (events[i].id == id) {
+            events.remove(i);
+            break;
+        }
+    }
+    arm();
+}
+
+void GameScheduler::cancelAll() {
+    events.clear();
+    timer->stop();
+}
+
+void GameScheduler::pause() {
+    if (paused) return;
+    rebase();
+    paused = true;
+    timer->stop();
+}
+
+void GameScheduler::resume() {
+    if (!paused) return;
+    clockBase = clock.elapsed();
+    paused = false;
+    arm();
+}
+
+void GameScheduler::setTimeScale(qreal scale) {
+    if (scale <= 0) return;
+    rebase();
+    timeScale = scale;
+    arm();
+}
+
+// 按最早到期的事件设置一次定时器
+void GameScheduler::arm() {
+    if (paused || events.isEmpty()) {
+        timer->stop();
+        return;
+    }
+    qint64 earliest = events.first().due;
+    for (const Event& e : events) earliest = qMin(earliest, e.due);
+    qint64 wait = qint64(std::ceil((earliest - now()) / timeScale));
+    timer->start(int(qBound<qint64>(0, wait, INT_MAX)));
+}
+
+void GameScheduler::onTick() {
+    const qint64 t = now();
+    // 逐个取出最早到期的事件执行；回调里可能取消、新增事件或暂停
+    while (!paused) {
+        int next = -1;
+        for (int i = 0; i < events.size(); i++) {
+            if (events[i].due <= t && (next < 0 || events[i].due < events[next].due)) next = i;
+        }
+        if (next < 0) break;
+        Event e = events[next];
+        if (e.context.isNull()) {
+            events.remove(next);
+            continue;
+        }
+        if (e.interval > 0) {
+            events[next].due += e.interval;
+        } else {
+            events.remove(next);
+        }
+        e.fn();
+    }
+    arm();
+}
@@ -0,0 +1,58 @@
+#ifndef GAMESCHEDULER_H
+#define GAMESCHEDULER_H
+#include <QObject>
+#include <QVector>
+#include <QPointer>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <functional>
+
+// 游戏内所有定时事件的统一调度：延迟消除、自动求解的步进、提示高亮、倒计时。
+// 使用单调时钟计算游戏时间，暂停时游戏时间停止，未到期的事件一起推迟；
+// 一次触发时执行所有已到期的事件。周期事件按计划时间而不是实际执行时间推进，不会累积漂移。
+class GameScheduler : public QObject {
+    Q_OBJECT
+public:
+    typedef quint64 EventId;
+
+    explicit GameScheduler(QObject *parent = nullptr);
+
+    // context不能为空，被销毁后事件自动丢弃
+    EventId schedule(qint64 delayMs, QObject *context, std::function<void()> fn);
+    EventId scheduleRepeating(qint64 intervalMs, QObject *context, std::function<void()> fn);
+    void cancel(EventId id);
+    void cancelAll();
+
+    void pause();
+    void resume();
+    bool isPaused() const { return paused; }
+    void setTimeScale(qreal scale); // 大于1加速，用于演示和测试
+    qreal getTimeScale() const { return timeScale; }
+    qint64 now() const; // 游戏时间（毫秒）
+
+private slots:
+    void onTick();
+
+private:
+    struct Event {
+        EventId id;
+        qint64 due;      // 游戏时间
+        qint64 interval; // 0表示单次
+        QPointer<QObject> context;
+        std::function<void()> fn;
+    };
+
+    QElapsedTimer clock;
+    qint64 gameBase;  // 上次暂停/恢复/改变速度时的游戏时间
+    qint64 clockBase; // 同一时刻的时钟读数
+    qreal timeScale;
+    bool paused;
+    EventId nextId;
+    QVector<Event> events;
+    QTimer *timer;
+
+    void rebase();
+    void arm();
+};
+
+#endif
@@ -0,0 +1,254 @@
+#include "gameserver.h"
+#include "gamebot.h"
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QTimer>
+#include <QDebug>
+
+namespace {
+QAtomicInteger<quint32> nextSessionId(1);
+
+QJsonArray cellsToJson(const BoardEngine& engine) {
+    QJsonArray cells;
+    for (int i = 0; i < engine.rowCount(); i++) {
+        for (int j = 0; j < engine.colCount(); j++) cells.append(engine.at(i, j));
+    }
+    return cells;
+}
+
+QJsonObject error(const QString& op, const QString& message) {
+    return QJsonObject{{"op", op}, {"ok", false}, {"error", message}};
+}
+}
+
+void SessionShard::adopt(qintptr descriptor) {
+    QTcpSocket* socket = new QTcpSocket(this);
+    if (!socket->setSocketDescriptor(descriptor)) {
+        delete socket;
+        return;
+    }
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+    connect(socket, &QTcpSocket::disconnected, this, [this, socket]() { onDisconnected(socket); });
+}
+
+void SessionShard::onReadyRead(QTcpSocket* socket) {
+    QByteArray out;
+    while (socket->canReadLine()) {
+        QByteArray line = socket->readLine(GameServer::MAX_LINE_BYTES);
+        QJsonParseError err;
+        QJsonDocument doc = QJsonDocument::fromJson(line, &err);
+        QJsonObject reply = doc.isObject() ? handle(socket, doc.object()) : error("error", "bad request");
+        out += QJsonDocument(reply).toJson(QJsonDocument::Compact);
+        out += '\n';
+    }
+    // 一行过长说明对方不是合法客户端
+    if (!socket->canReadLine() && socket->bytesAvailable() > GameServer::MAX_LINE_BYTES) {
+        socket->abort();
+        return;
+    }
+    if (!out.isEmpty()) socket->write(out); // 一次读到的多个请求合并为一次写
+}
+
+void SessionShard::onDisconnected(QTcpSocket* socket) {
+    for (auto it = sessions.begin(); it != sessions.end(); ) {
+        if (it->owner == socket) {
+            it = sessions.erase(it);
+            sessionTotal.fetchAndSubRelaxed(1);
+        } else {
+            ++it;
+        }
+    }
+    socket->deleteLater();
+}
+
+QJsonObject SessionShard::handle(QTcpSocket* socket, const QJsonObject& request) {
+    QString op = request.value("op").toString();
+    if (op == "join") return join(socket, request);
+
+    auto it = sessions.find(quint32(request.value("session").toInteger()));
+    if (it == sessions.end() || it->owner != socket) return error(op, "unknown session");
+    if (op == "move") return move(*it, request);
+    if (op == "shuffle") return shuffle(*it);
+    if (op == "leave") {
+        QJsonObject reply{{"op", op}, {"ok", true}, {"session", qint64(it->id)}, {"score", it->score}};
+        sessions.erase(it);
+        sessionTotal.fetchAndSubRelaxed(1);
+        return reply;
+    }
+    return error(op, "unknown op");
+}
+
+const SessionShard::TableLayout& SessionShard::layoutFor(quint64 seed, int rows, int cols, Difficulty difficulty) {
+    QString key = QString("%1/%2x%3/%4").arg(seed).arg(rows).arg(cols).arg(difficulty);
+    auto it = layouts.find(key);
+    if (it == layouts.end()) {
+        // 与GameBoard::newGame相同：先重置种子再生成，保证与单机版同种子同布局
+        GameRng rng(seed);
+        TableLayout t;
+        t.engine.setMap(BoardEngine::generateLayout(rows, cols, difficulty, rng));
+        t.rng = rng.state();
+        it = layouts.insert(key, t);
+    }
+    return *it;
+}
+
+QJsonObject SessionShard::join(QTcpSocket* socket, const QJsonObject& request) {
+    int owned = 0;
+    for (const GameSession& s : sessions) owned += s.owner == socket;
+    if (owned >= GameServer::MAX_SESSIONS_PER_CONNECTION) return error("join", "too many sessions");
+
+    int rows = request.value("rows").toInt(8);
+    int cols = request.value("cols").toInt(10);
+    int difficulty = request.value("difficulty").toInt(PRIMARY);
+    int shift = request.value("shift").toInt(SHIFT_NONE);
+    if (rows < 2 || cols < 2 || rows > 32 || cols > 32 || (rows * cols) % 2 != 0
+        || difficulty < BEGINNER || difficulty > ADVANCED || shift < SHIFT_NONE || shift > SHIFT_CENTER) {
+        return error("join", "bad parameters");
+    }
+    // 种子以字符串传递，JSON数字放不下64位整数
+    bool ok = false;
+    quint64 seed = request.value("seed").toString().toULongLong(&ok);
+    if (!ok) return error("join", "bad seed");
+
+    const TableLayout& t = layoutFor(seed, rows, cols, Difficulty(difficulty));
+    GameSession s;
+    s.id = nextSessionId.fetchAndAddRelaxed(1);
+    s.owner = socket;
+    s.player = request.value("player").toString().left(32);
+    s.seed = seed;
+    s.difficulty = Difficulty(difficulty);
+    s.engine = t.engine;
+    s.engine.setShiftRule(ShiftRule(shift));
+    s.rng.setState(t.rng);
+    s.score = 0;
+    s.moves = 0;
+    s.shuffles = 0;
+    sessions.insert(s.id, s);
+    sessionTotal.fetchAndAddRelaxed(1);
+
+    return QJsonObject{{"op", "join"}, {"ok", true}, {"session", qint64(s.id)},
+                       {"rows", rows}, {"cols", cols}, {"cells", cellsToJson(s.engine)}};
+}
+
+// 按单机版的规则校验：两格同图案、都未消除、最多两次转弯可连
+QJsonObject SessionShard::move(GameSession& s, const QJsonObject& request) {
+    const int cols = s.engine.colCount();
+    const int cellCount = s.engine.rowCount() * cols;
+    int ia = request.value("a").toInt(-1);
+    int ib = request.value("b").toInt(-1);
+    if (ia < 0 || ib < 0 || ia >= cellCount || ib >= cellCount || ia == ib) return error("move", "bad cell");
+    QPoint a(ia / cols, ia % cols), b(ib / cols, ib % cols);
+    if (s.engine.at(a) == 0 || s.engine.at(a) != s.engine.at(b)) return error("move", "tiles differ");
+    if (!s.engine.canLink(a, b, 2)) return error("move", "no link");
+
+    QVector<TileMove> shifted = s.engine.removePair(a, b);
+    s.score += BoardEngine::pointsFor(s.difficulty);
+    s.moves++;
+    moveCount.fetchAndAddRelaxed(1);
+
+    QJsonObject reply{{"op", "move"}, {"ok", true}, {"session", qint64(s.id)},
+                      {"score", s.score}, {"remaining", s.engine.remainingCount()}};
+    // 有移动规则时把移动告诉客户端，客户端据此更新本地棋盘
+    if (!shifted.isEmpty()) {
+        QJsonArray moves;
+        for (const TileMove& m : shifted) {
+            moves.append(QJsonArray{m.from.x() * cols + m.from.y(), m.to.x() * cols + m.to.y()});
+        }
+        reply["shifted"] = moves;
+    }
+    return reply;
+}
+
+QJsonObject SessionShard::shuffle(GameSession& s) {
+    // 与单机版一致：仍有可消除的对时重排扣分
+    QPoint ha, hb;
+    if (s.engine.findHint(ha, hb)) s.score -= qMin(s.score, 50);
+    s.engine.shuffleRemaining(s.rng);
+    s.shuffles++;
+    return QJsonObject{{"op", "shuffle"}, {"ok", true}, {"session", qint64(s.id)},
+                       {"score", s.score}, {"cells", cellsToJson(s.engine)}};
+}
+
+GameServer::GameServer(int shardCount, QObject* parent)
+    : QTcpServer(parent), nextShard(0)
+{
+    if (shardCount <= 0) shardCount = qMax(1, QThread::idealThreadCount());
+    for (int i = 0; i < shardCount; i++) {
+        QThread* thread = new QThread(this);
+        thread->setObjectName(QString("GameShard%1").arg(i));
+        SessionShard* shard = new SessionShard;
+        shard->moveToThread(thread);
+        connect(thread, &QThread::finished, shard, &QObject::deleteLater);
+        thread->start();
+        threads.append(thread);
+        shards.append(shard);
+    }
+}
+
+GameServer::~GameServer() {
+    close();
+    for (QThread* thread : threads) {
+        thread->quit();
+        thread->wait();
+    }
+}
+
+bool GameServer::start(quint16 port) {
+    if (!listen(QHostAddress::LocalHost, port)) {
+        qDebug() << "Game server cannot listen on port" << port << errorString();
+        return false;
+    }
+    qDebug() << "Game server listening on port" << serverPort() << "with" << shards.size() << "shards";
+    return true;
+}
+
+// 不创建QTcpSocket，只把描述符交给分片，套接字在分片线程上创建，读写都不经过主线程
+void GameServer::incomingConnection(qintptr descriptor) {
+    SessionShard* shard = shards[nextShard];
+    nextShard = (nextShard + 1) % shards.size();
+    QMetaObject::invokeMethod(shard, [shard, descriptor]() { shard->adopt(descriptor); }, Qt::QueuedConnection);
+}
+
+qint64 GameServer::movesHandled() const {
+    qint64 total = 0;
+    for (const SessionShard* shard : shards) total += shard->movesHandled();
+    return total;
+}
+
+int GameServer::sessionCount() const {
+    int total = 0;
+    for (const SessionShard* shard : shards) total += shard->sessionCount();
+    return total;
+}
+
+bool GameServer::headlessRequested() {
+    return !qEnvironmentVariableIsEmpty("LLK_SERVER_PORT");
+}
+
+int GameServer::runHeadless() {
+    quint16 port = quint16(qEnvironmentVariableIntValue("LLK_SERVER_PORT"));
+    GameServer server;
+    if (!server.start(port)) return 1;
+
+    // 同进程内的机器人用于压测；比赛时所有机器人使用同一种子
+    int botCount = qEnvironmentVariableIntValue("LLK_SERVER_BOTS");
+    QString seed = qEnvironmentVariable("LLK_SERVER_SEED", "1");
+    for (int i = 0; i < botCount; i++) {
+        GameBot* bot = new GameBot(QString("bot%1").arg(i), seed, &server);
+        bot->connectTo(server.serverPort());
+    }
+
+    // 每5秒输出一次吞吐量
+    QTimer stats;
+    qint64 lastMoves = 0;
+    QObject::connect(&stats, &QTimer::timeout, &server, [&server, &lastMoves]() {
+        qint64 moves = server.movesHandled();
+        qDebug().noquote() << QString("Game server: %1 sessions, %2 moves/s")
+                              .arg(server.sessionCount()).arg((moves - lastMoves) / 5.0, 0, 'f', 0);
+        lastMoves = moves;
+    });
+    stats.start(5000);
+    return QCoreApplication::exec();
+}
@@ -0,0 +1,91 @@
+#ifndef GAMESERVER_H
+#define GAMESERVER_H
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QHash>
+#include <QVector>
+#include <QJsonObject>
+#include <QAtomicInteger>
+#include "boardengine.h"
+
+// 一个玩家的一局。同一种子的多局共享初始布局：紧凑地图隐式共享，第一次消除时才复制
+struct GameSession {
+    quint32 id;
+    QTcpSocket* owner;
+    QString player;
+    quint64 seed;
+    Difficulty difficulty;
+    BoardEngine engine;
+    GameRng rng; // 重排使用，与单机版一样从生成布局后的状态继续
+    int score;
+    int moves;
+    int shuffles;
+};
+
+// 一个分片：在自己的线程上管理若干连接及其创建的会话，分片之间不共享可变状态，无需加锁
+class SessionShard : public QObject {
+    Q_OBJECT
+public:
+    explicit SessionShard(QObject* parent = nullptr) : QObject(parent) {}
+    qint64 movesHandled() const { return moveCount.loadRelaxed(); }
+    int sessionCount() const { return sessionTotal.loadRelaxed(); }
+
+public slots:
+    void adopt(qintptr descriptor); // 在本分片线程上接管新连接
+
+private:
+    // 同一种子和参数的布局只生成一次
+    struct TableLayout {
+        BoardEngine engine; // 新会话复制它，地图和索引都隐式共享
+        GameRng::State rng;
+    };
+
+    QHash<quint32, GameSession> sessions;
+    QHash<QString, TableLayout> layouts;
+    QAtomicInteger<qint64> moveCount;
+    QAtomicInteger<int> sessionTotal;
+
+    void onReadyRead(QTcpSocket* socket);
+    void onDisconnected(QTcpSocket* socket);
+    QJsonObject handle(QTcpSocket* socket, const QJsonObject& request);
+    QJsonObject join(QTcpSocket* socket, const QJsonObject& request);
+    QJsonObject move(GameSession& s, const QJsonObject& request);
+    QJsonObject shuffle(GameSession& s);
+    const TableLayout& layoutFor(quint64 seed, int rows, int cols, Difficulty difficulty);
+};
+
+// 无界面的多局对战服务器：本机TCP，每行一个JSON请求/响应。
+//   {"op":"join","player":"p","seed":"123","rows":8,"cols":10,"difficulty":1,"shift":0}
+//   {"op":"move","session":1,"a":12,"b":35}   格子编号为 行*列数+列
+//   {"op":"shuffle","session":1}
+//   {"op":"leave","session":1}
+// 连接按轮转分配给固定数量的分片线程，之后该连接的所有请求都在这个线程上处理。
+class GameServer : public QTcpServer {
+    Q_OBJECT
+public:
+    explicit GameServer(int shardCount = 0, QObject* parent = nullptr); // 0表示按CPU核数
+    ~GameServer();
+
+    bool start(quint16 port);
+    qint64 movesHandled() const;
+    int sessionCount() const;
+
+    static const int MAX_SESSIONS_PER_CONNECTION = 16;
+    static const int MAX_LINE_BYTES = 4096;
+
+    // 无界面运行：LLK_SERVER_PORT指定端口，LLK_SERVER_BOTS指定同进程内启动的机器人数，
+    // LLK_SERVER_SEED指定对局种子。需要已创建QCoreApplication，返回事件循环的退出码
+    static bool headlessRequested();
+    static int runHeadless();
+
+protected:
+    void incomingConnection(qintptr descriptor) override;
+
+private:
+    QVector<QThread*> threads;
+    QVector<SessionShard*> shards;
+    int nextShard;
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include "gamesnapshot.h"
+#include <QDataStream>
+#include <QSaveFile>
+#include <QFile>
+#include <QtConcurrent>
+#include <QDebug>
+
+namespace {
+const quint32 SNAPSHOT_MAGIC = 0x4C4C4B53; // "LLKS"
+const quint16 SNAPSHOT_VERSION = 1; // 格式变化时递增，旧版本的存档直接放弃
+}
+
+QByteArray GameSnapshot::encode() const {
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << SNAPSHOT_MAGIC << SNAPSHOT_VERSION << quint16(rows) << quint16(cols)
+        << quint8(difficulty) << quint8(shiftRule) << quint8(tileBytes)
+        << qint32(score) << qint32(timeLeft) << qint32(initialTime) << qint32(hintCount)
+        << qint32(pairsRemoved) << qint32(undoCount);
+    for (quint64 word : rng) out << word;
+    out << qCompress(BoardEngine::tilesLittleEndian(tiles, tileBytes), 1); // 级别1：够快，大棋盘上空格多时压缩效果明显
+    out << qChecksum(data);
+    return data;
+}
+
+bool GameSnapshot::decode(const QByteArray& data, GameSnapshot& out) {
+    if (data.size() < 2) return false;
+    QByteArray body = data.left(data.size() - 2);
+    QDataStream in(data);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 magic;
+    quint16 version, r, c;
+    quint8 diff, shift, width;
+    qint32 score, timeLeft, initialTime, hintCount, removed, undos;
+    in >> magic >> version >> r >> c >> diff >> shift >> width;
+    if (magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION) return false;
+    in >> score >> timeLeft >> initialTime >> hintCount >> removed >> undos;
+    if (diff > ADVANCED || shift > SHIFT_CENTER || (width != 1 && width != 2)) return false;
+
+    GameRng::State rng;
+    for (quint64& word : rng) in >> word;
+    QByteArray packed;
+    quint16 checksum;
+    in >> packed >> checksum;
+    if (in.status() != QDataStream::Ok || checksum != qChecksum(body)) return false;
+
+    QByteArray tiles = qUncompress(packed);
+    if (tiles.size() != int(r) * int(c) * width) return false;
+
+    out.rows = r;
+    out.cols = c;
+    out.difficulty = Difficulty(diff);
+    out.shiftRule = ShiftRule(shift);
+    out.score = score;
+    out.timeLeft = timeLeft;
+    out.initialTime = initialTime;
+    out.hintCount = hintCount;
+    out.pairsRemoved = removed;
+    out.undoCount = undos;
+    out.rng = rng;
+    out.tiles = BoardEngine::tilesLittleEndian(tiles, width);
+    out.tileBytes = width;
+    return true;
+}
+
+SnapshotWriter::SnapshotWriter(const QString& path, QObject *parent)
+    : QObject(parent), path(path), hasPending(false), discardAfterWrite(false)
+{
+    watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, &QFutureWatcher<bool>::finished, this, &SnapshotWriter::onWriteFinished);
+}
+
+SnapshotWriter::~SnapshotWriter() {
+    waitForFinished();
+}
+
+void SnapshotWriter::save(const GameSnapshot& snapshot) {
+    discardAfterWrite = false;
+    if (watcher->isRunning()) {
+        pending = snapshot; // 只保留最新的一份
+        hasPending = true;
+        return;
+    }
+    startWrite(snapshot);
+}
+
+void SnapshotWriter::startWrite(const GameSnapshot& snapshot) {
+    QString target = path;
+    watcher->setFuture(QtConcurrent::run([snapshot, target]() {
+        // QSaveFile先写临时文件再改名，崩溃时不会留下半个存档
+        QSaveFile f(target);
+        if (!f.open(QIODevice::WriteOnly)) return false;
+        f.write(snapshot.encode());
+        return f.commit();
+    }));
+}
+
+void SnapshotWriter::onWriteFinished() {
+    if (!watcher->result()) {
+        qDebug() << "Failed to write game snapshot" << path;
+    }
+    if (discardAfterWrite) {
+        discardAfterWrite = false;
+        QFile::remove(path);
+        return;
+    }
+    if (hasPending) {
+        hasPending = false;
+        startWrite(pending);
+        pending = GameSnapshot();
+    }
+}
+
+bool SnapshotWriter::load(GameSnapshot& out) const {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    return GameSnapshot::decode(f.readAll(), out);
+}
+
+void SnapshotWriter::discard() {
+    hasPending = false;
+    pending = GameSnapshot();
+    if (watcher->isRunning()) {
+        discardAfterWrite = true;
+    } else {
+        QFile::remove(path);
+    }
+}
+
+void SnapshotWriter::waitForFinished() {
+    watcher->waitForFinished();
+    if (discardAfterWrite) {
+        discardAfterWrite = false;
+        QFile::remove(path);
+    } else if (hasPending) {
+        hasPending = false;
+        startWrite(pending);
+        watcher->waitForFinished();
+    }
+}
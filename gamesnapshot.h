@@ -0,0 +1,58 @@
+#ifndef GAMESNAPSHOT_H
+#define GAMESNAPSHOT_H
+#include <QObject>
+#include <QByteArray>
+#include <QVector>
+#include <QFutureWatcher>
+#include "gameboard.h"
+#include "gamerng.h"
+
+// 一局进行中的游戏状态。tiles是引擎中按行优先打包的图案，与棋盘隐式共享，截取快照只增加引用计数，
+// 压缩在写盘线程上进行，之后棋盘再修改时才会分离出副本。
+struct GameSnapshot {
+    int rows = 0;
+    int cols = 0;
+    Difficulty difficulty = PRIMARY;
+    ShiftRule shiftRule = SHIFT_NONE;
+    int score = 0;
+    int timeLeft = 0;
+    int initialTime = 0;
+    int hintCount = 0;
+    int pairsRemoved = 0;
+    int undoCount = 0; // 本局剩余的撤销次数
+    GameRng::State rng = {};
+    QByteArray tiles; // BoardEngine::packedTiles()
+    int tileBytes = 1; // 每格字节数
+
+    // 定长头 + 压缩的图案（每格tileBytes字节，小端）+ 校验和；36格约90字节，10000格也只有几KB
+    QByteArray encode() const;
+    static bool decode(const QByteArray& data, GameSnapshot& out);
+};
+
+// 异步写入存档文件：写入在线程池上进行，写入期间到达的新快照只保留最新的一份，
+// 当前写完后再写，因此每步都保存也不会阻塞游戏或堆积写入。
+class SnapshotWriter : public QObject {
+    Q_OBJECT
+public:
+    explicit SnapshotWriter(const QString& path, QObject *parent = nullptr);
+    ~SnapshotWriter();
+
+    void save(const GameSnapshot& snapshot);
+    bool load(GameSnapshot& out) const; // 存档很小，同步读取
+    void discard();                     // 删除存档（包括正在写入的）
+    void waitForFinished();
+
+private slots:
+    void onWriteFinished();
+
+private:
+    QString path;
+    QFutureWatcher<bool> *watcher;
+    GameSnapshot pending;
+    bool hasPending;
+    bool discardAfterWrite;
+
+    void startWrite(const GameSnapshot& snapshot);
+};
+
+#endif
@@ -0,0 +1,115 @@
+#include "hintcache.h"
+#include "telemetry.h"
+
+namespace {
+const int DR[4] = {-1, 1, 0, 0};
+const int DC[4] = {0, 0, -1, 1};
+}
+
+bool HintCache::peek(QPoint& a, QPoint& b) const {
+    if (entries.isEmpty()) return false;
+    a = entries.first().a;
+    b = entries.first().b;
+    return true;
+}
+
+bool HintCache::hint(const BoardEngine& engine, QPoint& a, QPoint& b) {
+    if (entries.isEmpty()) refill(engine);
+    return peek(a, b);
+}
+
+bool HintCache::contains(const QPoint& a, const QPoint& b) const {
+    for (const Entry& e : entries) {
+        if ((e.a == a && e.b == b) || (e.a == b && e.b == a)) return true;
+    }
+    return false;
+}
+
+void HintCache::insert(const BoardEngine& engine, const QPoint& a, const QPoint& b) {
+    if (entries.size() >= CAPACITY || contains(a, b)) return;
+    QVector<QPoint> path = engine.findPathInternal(a, b, 2);
+    if (path.size() < 2) return;
+    entries.append({a, b, path});
+}
+
+// 与BoardEngine::findHint相同的顺序，但不在第一对处停下，最多收集CAPACITY对
+void HintCache::refill(const BoardEngine& engine) {
+    qint64 nodes = 0;
+    for (int i = 0; i < engine.rowCount() && entries.size() < CAPACITY; i++) {
+        for (int j = 0; j < engine.colCount() && entries.size() < CAPACITY; j++) {
+            int v = engine.at(i, j);
+            if (v == 0) continue;
+            QPoint p(i, j);
+            for (const QPoint& q : engine.positionsOf(v)) {
+                if (q.x() < i || (q.x() == i && q.y() <= j)) continue;
+                nodes++;
+                if (engine.canLink(p, q, 2)) {
+                    insert(engine, p, q);
+                    if (entries.size() >= CAPACITY) break;
+                }
+            }
+        }
+    }
+    Telemetry::record(Telemetry::SOLVER_NODES, nodes, entries.size());
+}
+
+// cell是否落在折线上（含拐点，不含两个端点）
+bool HintCache::pathCrosses(const QVector<QPoint>& path, const QPoint& cell) {
+    for (int k = 1; k < path.size(); k++) {
+        const QPoint& from = path[k - 1];
+        const QPoint& to = path[k];
+        if (from.x() == to.x() && cell.x() == from.x()
+            && cell.y() >= qMin(from.y(), to.y()) && cell.y() <= qMax(from.y(), to.y())) {
+            return cell != path.first() && cell != path.last();
+        }
+        if (from.y() == to.y() && cell.y() == from.y()
+            && cell.x() >= qMin(from.x(), to.x()) && cell.x() <= qMax(from.x(), to.x())) {
+            return cell != path.first() && cell != path.last();
+        }
+    }
+    return false;
+}
+
+void HintCache::update(const BoardEngine& engine, const QVector<QPoint>& vacated, const QVector<QPoint>& filled) {
+    for (int k = entries.size() - 1; k >= 0; k--) {
+        const Entry& e = entries[k];
+        bool stale = vacated.contains(e.a) || vacated.contains(e.b) || filled.contains(e.a) || filled.contains(e.b);
+        for (int f = 0; !stale && f < filled.size(); f++) stale = pathCrosses(e.path, filled[f]);
+        if (stale) entries.remove(k);
+    }
+    for (const QPoint& p : vacated) {
+        if (entries.size() >= CAPACITY) break;
+        if (engine.at(p) == 0) promoteFrom(engine, p);
+    }
+}
+
+// 经过freed的新连线，其某一段在freed所在的行或列上，且全为空格。
+// 这一段的端点要么就是图块，要么是拐点，拐点再沿直线到达的第一个图块就是端点。
+// 所以新可连对中至少一个端点是从freed直线可达的某个空格出发、沿直线碰到的第一个图块。
+void HintCache::promoteFrom(const BoardEngine& engine, const QPoint& freed) {
+    const int rows = engine.rowCount(), cols = engine.colCount();
+    auto inside = [&](const QPoint& p) { return p.x() >= 0 && p.x() < rows && p.y() >= 0 && p.y() < cols; };
+
+    QVector<QPoint> lineCells{freed};
+    for (int d = 0; d < 4; d++) {
+        for (QPoint p = freed + QPoint(DR[d], DC[d]); inside(p) && engine.at(p) == 0; p += QPoint(DR[d], DC[d])) {
+            lineCells.append(p);
+        }
+    }
+    QVector<QPoint> candidates;
+    for (const QPoint& e : lineCells) {
+        for (int d = 0; d < 4; d++) {
+            QPoint p = e + QPoint(DR[d], DC[d]);
+            while (inside(p) && engine.at(p) == 0) p += QPoint(DR[d], DC[d]);
+            if (inside(p) && !candidates.contains(p)) candidates.append(p);
+        }
+    }
+    for (const QPoint& p : candidates) {
+        for (const QPoint& q : engine.positionsOf(engine.at(p))) {
+            if (q != p && !contains(p, q) && engine.canLink(p, q, 2)) {
+                insert(engine, p, q);
+                if (entries.size() >= CAPACITY) return;
+            }
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef HINTCACHE_H
+#define HINTCACHE_H
+#include <QVector>
+#include <QPoint>
+#include "boardengine.h"
+
+// 最近找到的若干可消除对及其连线。消除只会让格子变空，不会挡住其他连线，
+// 所以只需丢弃端点被消除（或被移走）的项、连线经过新填入格子的项；
+// 新空出的格子可能让新的对变得可连，从这些格子出发局部查找补充进来。
+class HintCache {
+public:
+    static const int CAPACITY = 8;
+
+    void clear() { entries.clear(); }
+    bool isEmpty() const { return entries.isEmpty(); }
+    bool peek(QPoint& a, QPoint& b) const; // 只看缓存，不计算
+    bool hint(const BoardEngine& engine, QPoint& a, QPoint& b); // 缓存为空时全盘查找并填满
+    void insert(const BoardEngine& engine, const QPoint& a, const QPoint& b);
+    // 棋盘已更新：vacated为变空的格子（包括被消除的两格和移走图块的原位置），filled为新放入图块的格子
+    void update(const BoardEngine& engine, const QVector<QPoint>& vacated, const QVector<QPoint>& filled);
+
+private:
+    struct Entry {
+        QPoint a;
+        QPoint b;
+        QVector<QPoint> path; // findPathInternal返回的折线
+    };
+    QVector<Entry> entries;
+
+    bool contains(const QPoint& a, const QPoint& b) const;
+    void refill(const BoardEngine& engine);
+    void promoteFrom(const BoardEngine& engine, const QPoint& freed);
+    static bool pathCrosses(const QVector<QPoint>& path, const QPoint& cell);
+};
+
+#endif
@@ -0,0 +1,140 @@
+#include "leaderboard.h"
+#include <QDataStream>
+#include <algorithm>
+
+Leaderboard::Leaderboard(int capacity)
+    : capacity(capacity), total(0), latestValid(false)
+{
+}
+
+void Leaderboard::build(const QVector<Record>& topRecords, const QVector<qint32>& allScores) {
+    top = topRecords.mid(0, capacity);
+    counts.clear();
+    tree.clear();
+    total = 0;
+
+    int maxScore = 0;
+    for (qint32 s : allScores) maxScore = qMax(maxScore, int(s));
+    grow(maxScore);
+    for (qint32 s : allScores) countScore(s);
+}
+
+void Leaderboard::add(const Record& r) {
+    insert(r);
+    latestRecord = r;
+    latestValid = true;
+}
+
+void Leaderboard::insert(const Record& r) {
+    // 同分时新记录排在后面，与存储索引的顺序一致
+    auto it = std::upper_bound(top.begin(), top.end(), r, [](const Record& a, const Record& b) {
+        return a.score > b.score;
+    });
+    if (it - top.begin() < capacity) {
+        top.insert(it, r);
+        if (top.size() > capacity) top.removeLast();
+    }
+    countScore(r.score);
+}
+
+int Leaderboard::rankOf(int score) const {
+    return total - countAtMost(score) + 1;
+}
+
+void Leaderboard::countScore(int score) {
+    score = qMax(0, score);
+    if (score + 1 >= tree.size()) grow(score);
+    counts[score]++;
+    for (int i = score + 1; i < tree.size(); i += i & -i) {
+        tree[i]++;
+    }
+    total++;
+}
+
+int Leaderboard::countAtMost(int score) const {
+    if (score < 0) return 0;
+    int i = qMin(score + 1, tree.size() - 1);
+    int sum = 0;
+    for (; i > 0; i -= i & -i) {
+        sum += tree[i];
+    }
+    return sum;
+}
+
+// 分数范围扩大时按倍数扩容，并用线性算法重建树状数组
+void Leaderboard::grow(int maxScore) {
+    int size = qMax(1024, counts.size());
+    while (size <= maxScore) size *= 2;
+    if (size == counts.size()) return;
+
+    counts.resize(size);
+    rebuildTree();
+}
+
+void Leaderboard::rebuildTree() {
+    int size = counts.size();
+    tree = QVector<int>(size + 1, 0);
+    for (int i = 1; i <= size; i++) {
+        tree[i] += counts[i - 1];
+        int parent = i + (i & -i);
+        if (parent <= size) tree[parent] += tree[i];
+    }
+}
+
+void Leaderboard::write(QDataStream& out) const {
+    out << qint32(top.size());
+    for (const Record& r : top) {
+        out << qint32(r.id) << qint32(r.score) << qint32(r.time) << r.playerName << r.difficulty << r.dateTime;
+    }
+    // 计数大多为0，只写非零的分数
+    qint32 nonZero = 0;
+    for (int c : counts) {
+        if (c) nonZero++;
+    }
+    out << nonZero;
+    for (int s = 0; s < counts.size(); s++) {
+        if (counts[s]) out << qint32(s) << qint32(counts[s]);
+    }
+}
+
+bool Leaderboard::read(QDataStream& in) {
+    qint32 n;
+    in >> n;
+    if (in.status() != QDataStream::Ok || n < 0 || n > capacity) return false;
+    QVector<Record> rs;
+    for (int i = 0; i < n && in.status() == QDataStream::Ok; i++) {
+        Record r;
+        qint32 id, score, time;
+        in >> id >> score >> time >> r.playerName >> r.difficulty >> r.dateTime;
+        r.id = id;
+        r.score = score;
+        r.time = time;
+        rs.append(r);
+    }
+
+    qint32 nonZero;
+    in >> nonZero;
+    if (in.status() != QDataStream::Ok || nonZero < 0) return false;
+    QVector<QPair<qint32, qint32>> pairs;
+    int maxScore = 0;
+    for (int i = 0; i < nonZero && in.status() == QDataStream::Ok; i++) {
+        qint32 score, c;
+        in >> score >> c;
+        if (score < 0 || c <= 0) return false;
+        pairs.append(qMakePair(score, c));
+        maxScore = qMax(maxScore, int(score));
+    }
+    if (in.status() != QDataStream::Ok) return false;
+
+    top = rs;
+    counts.clear();
+    tree.clear();
+    total = 0;
+    grow(maxScore);
+    for (const auto& p : pairs) {
+        counts[p.first] += p.second;
+        total += p.second;
+    }
+    rebuildTree();
+    return true;
+}
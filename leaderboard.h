@@ -0,0 +1,42 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+#include <QVector>
+#include "recordmanager.h"
+
+class QDataStream;
+
+// 单个难度的排行榜：只保留前capacity条记录，另用按分数计数的树状数组
+// 回答“某分数排第几”，插入和查询都是O(log S)（S为最高分）。
+class Leaderboard {
+public:
+    explicit Leaderboard(int capacity = 100);
+
+    void build(const QVector<Record>& topRecords, const QVector<qint32>& allScores);
+    void add(const Record& r);
+    void insert(const Record& r); // 同add，但不算作本次运行保存的记录
+    int rankOf(int score) const; // 1表示第一名
+    int count() const { return total; }
+    const QVector<Record>& entries() const { return top; }
+    bool hasLatest() const { return latestValid; }
+    const Record& latest() const { return latestRecord; } // 本次运行最近保存的一条
+
+    // 持久化前capacity条记录和各分数的计数，下次启动不必扫描全部分数
+    void write(QDataStream& out) const;
+    bool read(QDataStream& in);
+
+private:
+    int capacity;
+    QVector<Record> top;   // 按分数降序，最多capacity条
+    QVector<int> counts;   // counts[s]：分数为s的记录数
+    QVector<int> tree;     // counts的树状数组，下标从1开始
+    int total;
+    Record latestRecord;
+    bool latestValid;
+
+    void countScore(int score);
+    int countAtMost(int score) const;
+    void grow(int maxScore);
+    void rebuildTree();
+};
+
+#endif
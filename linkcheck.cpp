@@ -0,0 +1,223 @@
+#include "linkcheck.h"
+#include "boardengine.h"
+#include "gamerng.h"
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QDebug>
+#include <climits>
+#include <deque>
+
+namespace {
+const int DR[4] = {-1, 1, 0, 0};
+const int DC[4] = {0, 0, -1, 1};
+const int MAX_REPORTED = 5; // 最多打印的不一致样例
+
+struct Sample {
+    QPoint a;
+    QPoint b;
+    int maxTurns;
+};
+
+// 一种实现的计时累计
+struct KernelStats {
+    const char* name;
+    qint64 ns = 0;
+    qint64 calls = 0;
+    int mismatches = 0;
+};
+
+int randomInt(GameRng& rng, int lo, int hi) {
+    return lo + int(rng() % quint64(hi - lo + 1));
+}
+
+// 随机尺寸与密度；偶尔生成超过64列/行的棋盘，覆盖位图跨字的情况
+QVector<QVector<int>> randomBoard(GameRng& rng) {
+    bool wide = rng() % 10 == 0;
+    int rows = randomInt(rng, 1, wide ? 140 : 16);
+    int cols = randomInt(rng, 1, wide ? 140 : 16);
+    if (rows * cols < 2) cols = 2;
+    int density = randomInt(rng, 0, 100);
+    QVector<QVector<int>> map(rows, QVector<int>(cols, 0));
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            if (randomInt(rng, 1, 100) <= density) map[i][j] = randomInt(rng, 1, 8);
+        }
+    }
+    return map;
+}
+
+QString dumpBoard(const QVector<QVector<int>>& map) {
+    QStringList lines;
+    for (const QVector<int>& row : map) {
+        QString line;
+        for (int v : row) line += v == 0 ? QChar('.') : QChar('0' + v % 10);
+        lines << line;
+    }
+    return lines.join('\n');
+}
+
+void reportMismatch(KernelStats& stats, const QVector<QVector<int>>& map, const Sample& s,
+                    bool expected, const QString& got) {
+    if (stats.mismatches++ >= MAX_REPORTED) return;
+    qDebug().noquote() << QString("LinkCheck: %1 disagrees with reference at a=(%2,%3) b=(%4,%5) maxTurns=%6: "
+                                  "expected %7, got %8\n%9")
+                          .arg(stats.name).arg(s.a.x()).arg(s.a.y()).arg(s.b.x()).arg(s.b.y()).arg(s.maxTurns)
+                          .arg(expected ? "link" : "no link").arg(got).arg(dumpBoard(map));
+}
+}
+
+bool LinkCheck::referenceLink(const QVector<QVector<int>>& map, const QPoint& a, const QPoint& b, int maxTurns) {
+    const int rows = map.size();
+    const int cols = rows > 0 ? map[0].size() : 0;
+    if (a == b) return false;
+
+    // turns[(r*cols+c)*4+d]：沿方向d进入(r,c)时的最少转弯数
+    QVector<int> turns(rows * cols * 4, INT_MAX);
+    std::deque<int> queue;
+    for (int d = 0; d < 4; d++) {
+        int r = a.x() + DR[d], c = a.y() + DC[d];
+        if (r < 0 || r >= rows || c < 0 || c >= cols) continue;
+        if (QPoint(r, c) == b) return true;
+        if (map[r][c] != 0) continue;
+        turns[(r * cols + c) * 4 + d] = 0;
+        queue.push_back((r * cols + c) * 4 + d);
+    }
+    while (!queue.empty()) {
+        int state = queue.front();
+        queue.pop_front();
+        int cell = state / 4, dir = state % 4;
+        int r = cell / cols, c = cell % cols;
+        int t = turns[state];
+        for (int d = 0; d < 4; d++) {
+            int nt = t + (d != dir);
+            if (nt > maxTurns) continue;
+            int nr = r + DR[d], nc = c + DC[d];
+            if (nr < 0 || nr >= rows || nc < 0 || nc >= cols) continue;
+            if (QPoint(nr, nc) == b) return true;
+            if (map[nr][nc] != 0) continue;
+            int next = (nr * cols + nc) * 4 + d;
+            if (nt >= turns[next]) continue;
+            turns[next] = nt;
+            if (d == dir) queue.push_front(next);
+            else queue.push_back(next);
+        }
+    }
+    return false;
+}
+
+bool LinkCheck::isValidPath(const QVector<QVector<int>>& map, const QVector<QPoint>& path,
+                            const QPoint& a, const QPoint& b, int maxTurns) {
+    if (path.size() < 2 || path.first() != a || path.last() != b) return false;
+    if (path.size() - 2 > maxTurns) return false;
+    for (int k = 1; k < path.size(); k++) {
+        QPoint from = path[k - 1], to = path[k];
+        if (from == to || (from.x() != to.x() && from.y() != to.y())) return false;
+        int dr = (to.x() > from.x()) - (to.x() < from.x());
+        int dc = (to.y() > from.y()) - (to.y() < from.y());
+        // 线段内部以及拐点都必须是空格
+        for (QPoint p = from + QPoint(dr, dc); p != to; p += QPoint(dr, dc)) {
+            if (map[p.x()][p.y()] != 0) return false;
+        }
+        if (k < path.size() - 1 && (to == a || to == b || map[to.x()][to.y()] != 0)) return false;
+    }
+    return true;
+}
+
+int LinkCheck::run(int boards, quint64 seed, int pairsPerBoard) {
+    GameRng rng(seed);
+    KernelStats reference{"reference"};
+    KernelStats canLink{"canLink"};
+    KernelStats canLinkInternal{"canLinkInternal"};
+    KernelStats findPath{"findPathInternal"};
+    QVector<Sample> samples(pairsPerBoard);
+    QVector<char> expected(pairsPerBoard), linked(pairsPerBoard), linkedInternal(pairsPerBoard);
+    QVector<QVector<QPoint>> paths(pairsPerBoard);
+    QElapsedTimer timer;
+    QElapsedTimer total;
+    total.start();
+
+    for (int n = 0; n < boards; n++) {
+        QVector<QVector<int>> map = randomBoard(rng);
+        const int rows = map.size(), cols = map[0].size();
+        BoardEngine engine;
+        engine.setMap(map);
+        for (Sample& s : samples) {
+            int ca = randomInt(rng, 0, rows * cols - 1);
+            int cb = randomInt(rng, 0, rows * cols - 2);
+            if (cb >= ca) cb++;
+            s = {QPoint(ca / cols, ca % cols), QPoint(cb / cols, cb % cols), randomInt(rng, 0, 2)};
+        }
+
+        // 每种实现各自连续跑完整批，计时互不干扰
+        timer.start();
+        for (int i = 0; i < pairsPerBoard; i++) {
+            expected[i] = referenceLink(map, samples[i].a, samples[i].b, samples[i].maxTurns);
+        }
+        reference.ns += timer.nsecsElapsed();
+        timer.start();
+        for (int i = 0; i < pairsPerBoard; i++) {
+            linked[i] = engine.canLink(samples[i].a, samples[i].b, samples[i].maxTurns);
+        }
+        canLink.ns += timer.nsecsElapsed();
+        timer.start();
+        for (int i = 0; i < pairsPerBoard; i++) {
+            linkedInternal[i] = BoardEngine::canLinkInternal(map, samples[i].a, samples[i].b, samples[i].maxTurns);
+        }
+        canLinkInternal.ns += timer.nsecsElapsed();
+        timer.start();
+        for (int i = 0; i < pairsPerBoard; i++) {
+            paths[i] = engine.findPathInternal(samples[i].a, samples[i].b, samples[i].maxTurns);
+        }
+        findPath.ns += timer.nsecsElapsed();
+
+        for (int i = 0; i < pairsPerBoard; i++) {
+            const Sample& s = samples[i];
+            bool want = expected[i];
+            if (bool(linked[i]) != want) reportMismatch(canLink, map, s, want, linked[i] ? "link" : "no link");
+            if (bool(linkedInternal[i]) != want) {
+                reportMismatch(canLinkInternal, map, s, want, linkedInternal[i] ? "link" : "no link");
+            }
+            // 找不到时约定只返回[a]
+            bool pathOk = want ? isValidPath(map, paths[i], s.a, s.b, s.maxTurns)
+                               : paths[i].size() == 1 && paths[i].first() == s.a;
+            if (!pathOk) {
+                QStringList points;
+                for (const QPoint& p : paths[i]) points << QString("(%1,%2)").arg(p.x()).arg(p.y());
+                reportMismatch(findPath, map, s, want, "path " + points.join(' '));
+            }
+        }
+        reference.calls += pairsPerBoard;
+        canLink.calls += pairsPerBoard;
+        canLinkInternal.calls += pairsPerBoard;
+        findPath.calls += pairsPerBoard;
+    }
+
+    int mismatches = 0;
+    for (const KernelStats* k : {&reference, &canLink, &canLinkInternal, &findPath}) {
+        double seconds = k->ns / 1e9;
+        qDebug().noquote() << QString("LinkCheck: %1 %2 pairs, %3 Mpairs/s, %4 ns/pair, %5 mismatches")
+                              .arg(k->name, -17).arg(k->calls)
+                              .arg(seconds > 0 ? k->calls / seconds / 1e6 : 0.0, 0, 'f', 2)
+                              .arg(k->calls > 0 ? double(k->ns) / k->calls : 0.0, 0, 'f', 1)
+                              .arg(k->mismatches);
+        mismatches += k->mismatches;
+    }
+    qDebug().noquote() << QString("LinkCheck: %1 boards, seed %2, %3 mismatches, %4 s")
+                          .arg(boards).arg(seed).arg(mismatches).arg(total.elapsed() / 1000.0, 0, 'f', 1);
+    return mismatches;
+}
+
+void LinkCheck::runFromEnvironment() {
+    QString spec = qEnvironmentVariable("LLK_LINK_CHECK");
+    if (spec.isEmpty()) return;
+    QStringList parts = spec.split(',');
+    int boards = parts[0].toInt();
+    if (boards <= 0) boards = 10000;
+    // 未指定种子时随机选取并打印，出错后可用同一种子复现
+    bool ok = false;
+    quint64 seed = parts.size() > 1 ? parts[1].toULongLong(&ok) : 0;
+    if (!ok) seed = QRandomGenerator::global()->generate64();
+    QtConcurrent::run([boards, seed]() { run(boards, seed); });
+}
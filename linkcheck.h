@@ -0,0 +1,26 @@
+#ifndef LINKCHECK_H
+#define LINKCHECK_H
+#include <QVector>
+#include <QPoint>
+
+// 连线规则的参考实现与随机对拍。
+// canLink、canLinkInternal、findPathInternal是同一规则的三份手写实现，优化其中任何一个前后
+// 都应与参考实现对拍：随机生成大量棋盘和格子对，逐一比较结果并报告各实现的吞吐量。
+// 设置环境变量LLK_LINK_CHECK=棋盘数[,种子]后，启动时在线程池上运行一次，结果输出到调试日志。
+namespace LinkCheck {
+
+// 参考实现：按(格子, 方向)做0-1广度优先搜索，求a到b的最少转弯数，路径只经过空格且不出棋盘
+bool referenceLink(const QVector<QVector<int>>& map, const QPoint& a, const QPoint& b, int maxTurns);
+
+// 检查findPathInternal返回的折线：首尾为a、b，各段水平或竖直且经过的格子为空，转弯不超过maxTurns
+bool isValidPath(const QVector<QVector<int>>& map, const QVector<QPoint>& path,
+                 const QPoint& a, const QPoint& b, int maxTurns);
+
+// 运行对拍，返回不一致的次数
+int run(int boards, quint64 seed, int pairsPerBoard = 256);
+
+void runFromEnvironment();
+
+}
+
+#endif
@@ -1,97 +1,133 @@
 #include "mainwindow.h"
 #include "recorddialog.h"
+#include "startuptrace.h"
+#include "linkcheck.h"
+#include "spectatorfeed.h"
+#include "telemetry.h"
+#include <QCoreApplication>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QMessageBox>
 #include <QGroupBox>
-#include <QFileInfo>
-#include <QDir>
 #include <QDebug>
 #include <QUrl>
+#include <QShowEvent>
 
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent), score(0), timeLeft(120), initialTime(120), hintCount(3),
-      isPaused(false), isPlaying(false)
+    : QMainWindow(parent), score(0), timeLeft(120), initialTime(120), hintCount(3), undoCount(3),
+      isPaused(false), isPlaying(false), hintPending(false), stuckPending(false),
+      resetPending(false), movesSinceSnapshot(0)
 {
+    StartupTrace::Scope trace("MainWindow");
     setupUI();
+    snapshots = new SnapshotWriter("savegame.dat", this);
+    // 记录存储在I/O线程上打开、建立排行榜，第一局结束前就已就绪
+    RecordManager::instance();
     
-    // 获取应用程序目录
-    QDir appDir = QDir::current();
-    QString basePath = appDir.absolutePath();
-    
-    // 初始化音效 - 尝试多种路径
-    matchSoundAudio = new QAudioOutput(this);
-    matchSoundPlayer = new QMediaPlayer(this);
-    matchSoundPlayer->setAudioOutput(matchSoundAudio);
-    QStringList matchPaths = {
-        QDir::cleanPath(basePath + "/sounds/相连音效.mp3"),
-        QDir::cleanPath(basePath + "/../sounds/相连音效.mp3"),
-        "sounds/相连音效.mp3",
-        "./sounds/相连音效.mp3"
-    };
-    for (const QString& path : matchPaths) {
-        QFileInfo fi(path);
-        if (fi.exists() && fi.isReadable()) {
-            matchSoundPlayer->setSource(QUrl::fromLocalFile(path));
-            qDebug() << "Loaded match sound:" << path;
-            break;
-        }
-    }
-    matchSoundAudio->setVolume(0.5);
-    
-    winSoundAudio = new QAudioOutput(this);
-    winSoundPlayer = new QMediaPlayer(this);
-    winSoundPlayer->setAudioOutput(winSoundAudio);
-    QStringList winPaths = {
-        QDir::cleanPath(basePath + "/sounds/胜利.mp3"),
-        QDir::cleanPath(basePath + "/../sounds/胜利.mp3"),
-        "sounds/胜利.mp3",
-        "./sounds/胜利.mp3"
-    };
-    for (const QString& path : winPaths) {
-        QFileInfo fi(path);
-        if (fi.exists() && fi.isReadable()) {
-            winSoundPlayer->setSource(QUrl::fromLocalFile(path));
-            qDebug() << "Loaded win sound:" << path;
-            break;
-        }
-    }
-    winSoundAudio->setVolume(0.6);
-    
-    // 背景音乐
-    bgmAudio = new QAudioOutput(this);
-    bgmPlayer = new QMediaPlayer(this);
-    bgmPlayer->setAudioOutput(bgmAudio);
-    QStringList bgmPaths = {
-        QDir::cleanPath(basePath + "/sounds/bgm.mp3"),
-        QDir::cleanPath(basePath + "/../sounds/bgm.mp3"),
-        "sounds/bgm.mp3",
-        "./sounds/bgm.mp3"
-    };
-    for (const QString& path : bgmPaths) {
-        QFileInfo fi(path);
-        if (fi.exists() && fi.isReadable()) {
-            bgmPlayer->setSource(QUrl::fromLocalFile(path));
-            qDebug() << "Loaded BGM:" << path;
-            break;
-        }
+    // 音频后端在窗口显示后才初始化，见showEvent；初始化完成即启动结束
+    media = new MediaService(this);
+    connect(media, &MediaService::initialized, this, &StartupTrace::finish);
+    LinkCheck::runFromEnvironment(); // 仅在设置了LLK_LINK_CHECK时运行
+    connect(qApp, &QCoreApplication::aboutToQuit, qApp, &Telemetry::shutdown);
+    
+    // 观战：LLK_SPECTATOR_SOCKET指定本地套接字名
+    QString spectatorName = qEnvironmentVariable("LLK_SPECTATOR_SOCKET");
+    if (!spectatorName.isEmpty()) {
+        SpectatorFeed *feed = new SpectatorFeed(this);
+        if (feed->listen(spectatorName)) board->setSpectatorFeed(feed);
     }
-    bgmAudio->setVolume(0.3);
-    bgmPlayer->setLoops(QMediaPlayer::Infinite);
     
     // 连接信号
     connect(board, &GameBoard::pairRemoved, this, &MainWindow::onPairRemoved);
+    connect(board, &GameBoard::pairRestored, this, &MainWindow::onPairRestored);
     connect(board, &GameBoard::bonusTime, this, &MainWindow::onBonusTime);
     connect(board, &GameBoard::pairMatched, this, &MainWindow::onPairMatched);
+    connect(board, &GameBoard::hintReady, this, &MainWindow::onHintReady);
+    connect(board, &GameBoard::stuckChecked, this, &MainWindow::onStuckChecked);
+    // 棋盘变化后旧的查询结果会被丢弃：提示在新棋盘上重新查找；
+    // 僵局检查由棋盘变化触发（消除、重排、新局），每次变化只算一次
+    connect(board, &GameBoard::boardChanged, this, [this]() {
+        if (hintPending) board->requestHint();
+        if (resetPending) board->requestStuckCheck();
+        stuckPending = false;
+        checkStuck();
+    });
     
     updateUI();
+    QTimer::singleShot(0, this, &MainWindow::offerResume);
 }
 
 MainWindow::~MainWindow() {
-    // Qt会自动清理子对象
+    // 关闭窗口时保存进行中的游戏，下次启动可继续
+    if (isPlaying) {
+        saveSnapshot();
+    }
+    snapshots->waitForFinished();
+}
+
+void MainWindow::showEvent(QShowEvent *event) {
+    QMainWindow::showEvent(event);
+    if (!event->spontaneous()) {
+        StartupTrace::record("firstShow", 0, StartupTrace::nowUs());
+        media->initializeLater();
+    }
+}
+
+GameSnapshot MainWindow::captureSnapshot() const {
+    GameSnapshot s;
+    const BoardEngine& engine = board->boardEngine();
+    s.rows = engine.rowCount();
+    s.cols = engine.colCount();
+    s.tiles = engine.packedTiles();
+    s.tileBytes = engine.tileWidth();
+    s.difficulty = board->getDifficulty();
+    s.shiftRule = board->getShiftRule();
+    s.score = score;
+    s.timeLeft = timeLeft;
+    s.initialTime = initialTime;
+    s.hintCount = hintCount;
+    s.undoCount = undoCount;
+    s.pairsRemoved = board->getPairsRemoved();
+    s.rng = board->rngState();
+    return s;
+}
+
+void MainWindow::saveSnapshot() {
+    movesSinceSnapshot = 0;
+    snapshots->save(captureSnapshot());
+}
+
+void MainWindow::offerResume() {
+    GameSnapshot s;
+    if (!snapshots->load(s)) return;
+    if (QMessageBox::question(this, "Resume Game", "An unfinished game was found. Resume it?")
+        != QMessageBox::Yes || !board->restoreState(s.rows, s.cols, s.tiles, s.tileBytes, s.pairsRemoved, s.rng)) {
+        snapshots->discard();
+        return;
+    }
+    
+    difficultyCombo->setCurrentIndex(difficultyCombo->findData(int(s.difficulty)));
+    shiftCombo->setCurrentIndex(shiftCombo->findData(int(s.shiftRule)));
+    board->setDifficulty(s.difficulty);
+    board->setShiftRule(s.shiftRule);
+    score = s.score;
+    timeLeft = s.timeLeft;
+    initialTime = s.initialTime;
+    hintCount = s.hintCount;
+    undoCount = s.undoCount;
+    isPlaying = true;
+    hintPending = false;
+    stuckPending = false;
+    resetPending = false;
+    // 以暂停状态恢复，由玩家点继续开始计时
+    isPaused = true;
+    scheduler->pause();
+    countdownEvent = scheduler->scheduleRepeating(1000, this, [this]() { updateTime(); });
+    updateUI();
 }
 
 void MainWindow::setupUI() {
+    StartupTrace::Scope trace("setupUI");
     QWidget *central = new QWidget(this);
     setCentralWidget(central);
 
@@ -131,12 +167,16 @@ void MainWindow::setupUI() {
         "QPushButton:pressed { background: #0D47A1; } "
         "QPushButton:disabled { background: #BBDEFB; border-color: #90CAF9; color: #757575; }";
     
+    qint64 buttonsStart = StartupTrace::nowUs();
     startBtn = new QPushButton("▶ Start", this);
     pauseBtn = new QPushButton("⏸ Pause", this);
     pauseBtn->setEnabled(false);
     endBtn   = new QPushButton("■ End", this);
     hintBtn  = new QPushButton("💡 Hint", this);
     hintBtn->setEnabled(false);
+    undoBtn  = new QPushButton("↩ Undo (3)", this);
+    undoBtn->setEnabled(false);
+    undoBtn->setShortcut(QKeySequence::Undo);
     resetBtn = new QPushButton("🔄 Reset", this);
     resetBtn->setEnabled(false);
     autoSolveBtn = new QPushButton("⚡ Auto", this);
@@ -147,9 +187,11 @@ void MainWindow::setupUI() {
     pauseBtn->setStyleSheet(buttonStyle);
     endBtn->setStyleSheet(buttonStyle.replace("#2196F3", "#F44336").replace("#1976D2", "#C62828"));
     hintBtn->setStyleSheet(buttonStyle.replace("#2196F3", "#FF9800").replace("#1976D2", "#E65100"));
+    undoBtn->setStyleSheet(buttonStyle.replace("#2196F3", "#009688").replace("#1976D2", "#00695C"));
     resetBtn->setStyleSheet(buttonStyle.replace("#2196F3", "#FFC107").replace("#1976D2", "#F57C00"));
     autoSolveBtn->setStyleSheet(buttonStyle.replace("#2196F3", "#9C27B0").replace("#1976D2", "#6A1B9A"));
     recordBtn->setStyleSheet(buttonStyle.replace("#2196F3", "#607D8B").replace("#1976D2", "#37474F"));
+    StartupTrace::record("buttons", buttonsStart, StartupTrace::nowUs());
 
     // 难度选择
     difficultyCombo = new QComboBox(this);
@@ -167,6 +209,14 @@ void MainWindow::setupUI() {
         "border-right: 5px solid transparent; border-top: 5px solid #1976D2; width: 0; height: 0; }");
     difficultyCombo->setEnabled(true);
     
+    // 关卡变体
+    shiftCombo = new QComboBox(this);
+    shiftCombo->addItem("No Shift", SHIFT_NONE);
+    shiftCombo->addItem("⬇ Slide Down", SHIFT_DOWN);
+    shiftCombo->addItem("⬅ Slide Left", SHIFT_LEFT);
+    shiftCombo->addItem("↔ Slide to Centre", SHIFT_CENTER);
+    shiftCombo->setStyleSheet(difficultyCombo->styleSheet());
+    
     // 自动重置选项
     autoResetCheck = new QCheckBox("Auto Reset on Stuck", this);
     autoResetCheck->setChecked(true);
@@ -183,6 +233,7 @@ void MainWindow::setupUI() {
     infoLayout->addWidget(hintLabel);
     infoLayout->addWidget(difficultyLabel);
     infoLayout->addWidget(difficultyCombo);
+    infoLayout->addWidget(shiftCombo);
     infoLayout->addStretch();
     
     QHBoxLayout *buttonLayout = new QHBoxLayout;
@@ -190,6 +241,7 @@ void MainWindow::setupUI() {
     buttonLayout->addWidget(pauseBtn);
     buttonLayout->addWidget(endBtn);
     buttonLayout->addWidget(hintBtn);
+    buttonLayout->addWidget(undoBtn);
     buttonLayout->addWidget(resetBtn);
     buttonLayout->addWidget(autoSolveBtn);
     buttonLayout->addWidget(recordBtn);
@@ -209,18 +261,15 @@ void MainWindow::setupUI() {
     central->setLayout(main);
 
     // 定时器
-    timer = new QTimer(this);
-    connect(timer, &QTimer::timeout, this, &MainWindow::updateTime);
-    
-    stuckCheckTimer = new QTimer(this);
-    connect(stuckCheckTimer, &QTimer::timeout, this, &MainWindow::checkStuck);
-    stuckCheckTimer->start(2000); // 每2秒检查一次是否僵局
+    scheduler = board->getScheduler();
+    countdownEvent = 0;
 
     // 连接信号
     connect(startBtn, &QPushButton::clicked, this, &MainWindow::startGame);
     connect(pauseBtn, &QPushButton::clicked, this, &MainWindow::pauseGame);
     connect(endBtn, &QPushButton::clicked, this, &MainWindow::endGame);
     connect(hintBtn, &QPushButton::clicked, this, &MainWindow::showHint);
+    connect(undoBtn, &QPushButton::clicked, this, &MainWindow::undoMove);
     connect(resetBtn, &QPushButton::clicked, this, &MainWindow::resetRemaining);
     connect(autoSolveBtn, &QPushButton::clicked, this, &MainWindow::autoSolve);
     connect(recordBtn, &QPushButton::clicked, this, [=](){ 
@@ -238,15 +287,22 @@ void MainWindow::startGame() {
     score = 0;
     timeLeft = initialTime = 120;
     hintCount = 3;
+    undoCount = 3;
     isPaused = false;
     isPlaying = true;
+    hintPending = false;
+    stuckPending = false;
+    resetPending = false;
     
     Difficulty d = static_cast<Difficulty>(difficultyCombo->currentData().toInt());
     board->setDifficulty(d);
-    board->resetBoard(false);
+    board->setShiftRule(static_cast<ShiftRule>(shiftCombo->currentData().toInt()));
+    board->resetBoard(false); // 同时清空上一局尚未执行的定时事件
+    saveSnapshot(); // 替换上一局的存档
     
-    timer->start(1000);
-    bgmPlayer->play();
+    scheduler->resume();
+    countdownEvent = scheduler->scheduleRepeating(1000, this, [this]() { updateTime(); });
+    media->playMusic();
     
     updateUI();
 }
@@ -258,24 +314,28 @@ void MainWindow::pauseGame() {
     }
     
     isPaused = true;
-    timer->stop();
-    bgmPlayer->pause();
+    scheduler->pause(); // 倒计时、待执行的消除和自动求解一起暂停
+    media->pauseMusic();
+    saveSnapshot();
     pauseBtn->setText("▶ Resume");
     hintBtn->setEnabled(false);
+    undoBtn->setEnabled(false);
     resetBtn->setEnabled(false);
     autoSolveBtn->setEnabled(false);
 }
 
 void MainWindow::resumeGame() {
     isPaused = false;
-    timer->start(1000);
-    bgmPlayer->play();
+    scheduler->resume();
+    media->playMusic();
     pauseBtn->setText("⏸ Pause");
     
     if (isPlaying) {
         hintBtn->setEnabled(hintCount > 0);
+        undoBtn->setEnabled(undoCount > 0);
         resetBtn->setEnabled(true);
         autoSolveBtn->setEnabled(true);
+        checkStuck(); // 暂停期间到达的结果被忽略了，结果已缓存，重新查询很便宜
     }
 }
 
@@ -312,6 +372,10 @@ void MainWindow::onPairRemoved(int points) {
     score += points;
     scoreLabel->setText(QString("Score: %1").arg(score));
     
+    if (++movesSinceSnapshot >= AUTOSAVE_MOVES && board->getRemainingCount() > 0) {
+        saveSnapshot();
+    }
+    
     // 检查是否完成
     if (board->getRemainingCount() == 0) {
         playWinSound();
@@ -324,6 +388,12 @@ void MainWindow::onPairRemoved(int points) {
     }
 }
 
+void MainWindow::onPairRestored(int points) {
+    if (!isPlaying) return;
+    score = qMax(0, score - points);
+    scoreLabel->setText(QString("Score: %1").arg(score));
+}
+
 void MainWindow::onBonusTime(int seconds) {
     timeLeft += seconds;
     initialTime += seconds; // 也增加初始时间，让进度条正确显示
@@ -338,19 +408,12 @@ void MainWindow::onPairMatched() {
 }
 
 void MainWindow::playMatchSound() {
-    if (matchSoundPlayer && matchSoundPlayer->source().isLocalFile()) {
-        matchSoundPlayer->stop();
-        matchSoundPlayer->setPosition(0);
-        matchSoundPlayer->play();
-    }
+    // 快速连续配对（例如自动求解）时各次音效叠加，不打断上一次
+    media->playEffect(SOUND_MATCH, 0.5);
 }
 
 void MainWindow::playWinSound() {
-    if (winSoundPlayer && winSoundPlayer->source().isLocalFile()) {
-        winSoundPlayer->stop();
-        winSoundPlayer->setPosition(0);
-        winSoundPlayer->play();
-    }
+    media->playEffect(SOUND_WIN, 0.6);
 }
 
 void MainWindow::showHint() {
@@ -359,15 +422,26 @@ void MainWindow::showHint() {
         QMessageBox::warning(this, "No Hints", "You have used all hints!");
         return;
     }
+    if (hintPending) return;
+    
+    // 在工作线程上查找，结果由onHintReady处理
+    hintPending = true;
+    board->requestHint();
+}
+
+void MainWindow::onHintReady(bool found, const QPoint& a, const QPoint& b) {
+    if (!hintPending) return;
+    hintPending = false;
+    if (!isPlaying || isPaused || hintCount <= 0) return;
     
-    QPoint a, b;
-    if (board->findHint(a, b)) {
+    if (found) {
         hintCount--;
         hintLabel->setText(QString("Hints: %1").arg(hintCount));
         board->highlight(a, b);
+        board->recordHint();
         
         // 3秒后清除高亮
-        QTimer::singleShot(3000, board, &GameBoard::clearHighlight);
+        scheduler->schedule(3000, board, [this]() { board->clearHighlight(); });
         
         if (hintCount == 0) {
             hintBtn->setEnabled(false);
@@ -377,12 +451,24 @@ void MainWindow::showHint() {
     }
 }
 
+void MainWindow::undoMove() {
+    if (!isPlaying || isPaused || undoCount <= 0) return;
+    // 没有可撤销的步骤或消除动画未结束时不消耗次数
+    if (!board->undoMove()) return;
+    undoCount--;
+    undoBtn->setText(QString("↩ Undo (%1)").arg(undoCount));
+    undoBtn->setEnabled(undoCount > 0);
+}
+
 void MainWindow::resetRemaining() {
-    if (!isPlaying || isPaused) return;
-    
-    // 检查重置前是否有解
-    bool hadSolution = board->hasSolvablePairs();
+    if (!isPlaying || isPaused || resetPending) return;
     
+    // 重置前是否有解在工作线程上检查，结果由onStuckChecked交给finishReset
+    resetPending = true;
+    board->requestStuckCheck();
+}
+
+void MainWindow::finishReset(bool hadSolution) {
     if (hadSolution) {
         int penalty = qMin(score, 50); // 最多扣50分
         score = qMax(0, score - penalty);
@@ -405,6 +491,7 @@ void MainWindow::autoSolve() {
                                     QMessageBox::Yes | QMessageBox::No);
     if (ret == QMessageBox::Yes) {
         hintBtn->setEnabled(false);
+        undoBtn->setEnabled(false);
         resetBtn->setEnabled(false);
         autoSolveBtn->setEnabled(false);
         board->solveAutomatically();
@@ -412,13 +499,34 @@ void MainWindow::autoSolve() {
 }
 
 void MainWindow::checkStuck() {
+    if (!isPlaying || isPaused || stuckPending) return;
+    if (board->getRemainingCount() == 0) return;
+    
+    // 在工作线程上检查，结果由onStuckChecked处理
+    stuckPending = true;
+    board->requestStuckCheck();
+}
+
+void MainWindow::onStuckChecked(bool stuck) {
+    if (resetPending) {
+        resetPending = false;
+        if (isPlaying && !isPaused) {
+            // 重排会改变棋盘，僵局检查随boardChanged重新进行
+            finishReset(!stuck);
+            return;
+        }
+    }
+    if (!stuckPending) return;
+    stuckPending = false;
     if (!isPlaying || isPaused) return;
     
-    if (board->isStuck() && board->getRemainingCount() > 0) {
+    if (stuck && board->getRemainingCount() > 0) {
         if (autoResetCheck->isChecked()) {
             QMessageBox::information(this, "⚠️ Stuck Detected", 
                                     "No solvable pairs found! Auto-resetting remaining pieces...");
-            resetRemaining();
+            // 已确认无解，不会扣分，直接重排而不必再扫描一遍
+            board->resetRemaining();
+            hintBtn->setEnabled(hintCount > 0);
         } else {
             QMessageBox::warning(this, "⚠️ Stuck!", 
                                 "No solvable pairs found! Use Reset Remaining button.");
@@ -436,8 +544,10 @@ void MainWindow::onDifficultyChanged(int index) {
 void MainWindow::endGame() {
     isPlaying = false;
     isPaused = false;
-    timer->stop();
-    bgmPlayer->stop();
+    scheduler->cancel(countdownEvent);
+    media->stopMusic();
+    snapshots->discard();
+    board->saveReplay("lastgame.replay");
     
     saveGameRecord();
     
@@ -459,9 +569,12 @@ void MainWindow::updateUI() {
     pauseBtn->setEnabled(isPlaying);
     pauseBtn->setText(isPaused ? "▶ Resume" : "⏸ Pause");
     hintBtn->setEnabled(isPlaying && !isPaused && hintCount > 0);
+    undoBtn->setText(QString("↩ Undo (%1)").arg(undoCount));
+    undoBtn->setEnabled(isPlaying && !isPaused && undoCount > 0);
     resetBtn->setEnabled(isPlaying && !isPaused);
     autoSolveBtn->setEnabled(isPlaying && !isPaused);
     difficultyCombo->setEnabled(!isPlaying);
+    shiftCombo->setEnabled(!isPlaying);
 }
 
 void MainWindow::saveGameRecord() {
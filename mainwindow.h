@@ -4,13 +4,14 @@
 #include <QLabel>
 #include <QPushButton>
 #include <QTimer>
-#include <QMediaPlayer>
-#include <QAudioOutput>
 #include <QComboBox>
 #include <QCheckBox>
 #include <QProgressBar>
 #include "gameboard.h"
 #include "recordmanager.h"
+#include "gamesnapshot.h"
+#include "mediaservice.h"
+#include "gamescheduler.h"
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -18,6 +19,9 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
     
+protected:
+    void showEvent(QShowEvent *event) override;
+    
 private slots:
     void startGame();
     void pauseGame();
@@ -25,13 +29,18 @@ private slots:
     void endGame();
     void updateTime();
     void onPairRemoved(int points);
+    void onPairRestored(int points);
     void onBonusTime(int seconds);
     void onPairMatched(); // 配对成功，播放音效
     void showHint();
+    void undoMove(); // 道具：撤销上一步
     void resetRemaining();
     void autoSolve();
     void checkStuck();
+    void onHintReady(bool found, const QPoint& a, const QPoint& b);
+    void onStuckChecked(bool stuck);
     void onDifficultyChanged(int index);
+    void offerResume(); // 启动后发现未完成的存档时询问是否继续
     
 private:
     QLabel *scoreLabel;
@@ -43,34 +52,41 @@ private:
     QPushButton *pauseBtn;
     QPushButton *endBtn;
     QPushButton *hintBtn;
+    QPushButton *undoBtn;
     QPushButton *resetBtn;
     QPushButton *autoSolveBtn;
     QPushButton *recordBtn;
     QComboBox *difficultyCombo;
+    QComboBox *shiftCombo; // 关卡变体：消除后图块的移动方向
     QCheckBox *autoResetCheck;
     
     GameBoard *board;
-    QTimer *timer;
-    QTimer *stuckCheckTimer;
-    QMediaPlayer *bgmPlayer;
-    QAudioOutput *bgmAudio;
-    QMediaPlayer *matchSoundPlayer;
-    QAudioOutput *matchSoundAudio;
-    QMediaPlayer *winSoundPlayer;
-    QAudioOutput *winSoundAudio;
+    GameScheduler *scheduler; // 由棋盘创建，倒计时与棋盘上的定时事件共用
+    GameScheduler::EventId countdownEvent;
+    MediaService *media; // 背景音乐与音效，延迟初始化
+    SnapshotWriter *snapshots; // 进行中游戏的存档，崩溃后可恢复
     
     int score;
     int timeLeft;
     int initialTime;
     int hintCount;
+    int undoCount; // 本局剩余的撤销次数
     bool isPaused;
     bool isPlaying;
+    bool hintPending;  // 后台提示查询进行中
+    bool stuckPending; // 后台僵局检查进行中
+    bool resetPending; // 重置剩余图块前的有解检查进行中
+    int movesSinceSnapshot;
+    static const int AUTOSAVE_MOVES = 3; // 每消除几对自动存档一次
     
     void updateUI();
+    void finishReset(bool hadSolution); // 有解时扣分，然后重排剩余图块
     void saveGameRecord();
     void setupUI();
     void playMatchSound();
     void playWinSound();
+    GameSnapshot captureSnapshot() const;
+    void saveSnapshot();
 };
 
 #endif
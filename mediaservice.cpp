@@ -0,0 +1,120 @@
+#include "mediaservice.h"
+#include "soundeffects.h"
+#include "startuptrace.h"
+#include <QtConcurrent>
+#include <QTimer>
+#include <QFileInfo>
+#include <QDir>
+#include <QUrl>
+#include <QDebug>
+
+MediaService::MediaService(QObject *parent)
+    : QObject(parent), started(false), ready(false), musicState(MusicStopped),
+      effects(nullptr), bgmPlayer(nullptr), bgmAudio(nullptr)
+{
+    probeWatcher = new QFutureWatcher<QStringList>(this);
+    connect(probeWatcher, &QFutureWatcher<QStringList>::finished, this, &MediaService::onPathsResolved);
+}
+
+void MediaService::initializeLater() {
+    QTimer::singleShot(INIT_DELAY_MS, this, &MediaService::initialize);
+}
+
+void MediaService::initialize() {
+    if (started) return;
+    started = true;
+    // 查找文件涉及多次磁盘访问，放到线程池上
+    probeWatcher->setFuture(QtConcurrent::run([]() {
+        StartupTrace::Scope trace("mediaProbe");
+        return QStringList{findSound("相连音效.mp3"), findSound("胜利.mp3"), findSound("bgm.mp3")};
+    }));
+}
+
+QString MediaService::findSound(const QString& fileName) {
+    QString basePath = QDir::current().absolutePath();
+    QStringList paths = {
+        QDir::cleanPath(basePath + "/sounds/" + fileName),
+        QDir::cleanPath(basePath + "/../sounds/" + fileName),
+        "sounds/" + fileName,
+        "./sounds/" + fileName
+    };
+    for (const QString& path : paths) {
+        QFileInfo fi(path);
+        if (fi.exists() && fi.isReadable()) return path;
+    }
+    return QString();
+}
+
+void MediaService::onPathsResolved() {
+    StartupTrace::Scope trace("mediaSetup");
+    QStringList paths = probeWatcher->result();
+
+    // 音效在后台解码为PCM，播放时无需再解码
+    effects = new SoundEffects(this);
+    if (!paths[0].isEmpty()) {
+        effects->load(SOUND_MATCH, paths[0]);
+        qDebug() << "Loaded match sound:" << paths[0];
+    }
+    if (!paths[1].isEmpty()) {
+        effects->load(SOUND_WIN, paths[1]);
+        qDebug() << "Loaded win sound:" << paths[1];
+    }
+
+    // 背景音乐
+    bgmAudio = new QAudioOutput(this);
+    bgmPlayer = new QMediaPlayer(this);
+    bgmPlayer->setAudioOutput(bgmAudio);
+    if (!paths[2].isEmpty()) {
+        bgmPlayer->setSource(QUrl::fromLocalFile(paths[2]));
+        qDebug() << "Loaded BGM:" << paths[2];
+    }
+    bgmAudio->setVolume(0.3);
+    bgmPlayer->setLoops(QMediaPlayer::Infinite);
+
+    ready = true;
+    applyMusicState();
+    for (const auto& e : queuedEffects) {
+        effects->play(e.first, e.second);
+    }
+    queuedEffects.clear();
+    emit initialized();
+}
+
+void MediaService::applyMusicState() {
+    switch (musicState) {
+        case MusicPlaying: bgmPlayer->play(); break;
+        case MusicPaused: bgmPlayer->pause(); break;
+        case MusicStopped: bgmPlayer->stop(); break;
+    }
+}
+
+void MediaService::playMusic() {
+    musicState = MusicPlaying;
+    if (ready) {
+        applyMusicState();
+    } else {
+        initialize(); // 在延迟初始化之前就需要播放，立即开始
+    }
+}
+
+void MediaService::pauseMusic() {
+    musicState = MusicPaused;
+    if (ready) applyMusicState();
+}
+
+void MediaService::stopMusic() {
+    musicState = MusicStopped;
+    if (ready) applyMusicState();
+}
+
+void MediaService::playEffect(SoundId id, qreal volume) {
+    if (ready) {
+        effects->play(id, volume);
+        return;
+    }
+    if (queuedEffects.size() >= MAX_QUEUED_EFFECTS) {
+        queuedEffects.removeFirst();
+    }
+    queuedEffects.append(qMakePair(id, volume));
+    initialize();
+}
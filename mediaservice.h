@@ -0,0 +1,59 @@
+#ifndef MEDIASERVICE_H
+#define MEDIASERVICE_H
+#include <QObject>
+#include <QVector>
+#include <QPair>
+#include <QStringList>
+#include <QFutureWatcher>
+#include <QMediaPlayer>
+#include <QAudioOutput>
+
+class SoundEffects;
+
+enum SoundId {
+    SOUND_MATCH, // 配对成功
+    SOUND_WIN    // 完成一局
+};
+
+// 背景音乐与音效的统一入口。音频后端和音频文件在窗口首次显示之后才初始化：
+// 文件查找在线程池上进行，播放器在查找完成后创建。就绪前的播放请求先排队，就绪后执行。
+class MediaService : public QObject {
+    Q_OBJECT
+public:
+    explicit MediaService(QObject *parent = nullptr);
+
+    void initializeLater(); // 窗口显示后调用，空闲片刻再初始化
+    bool isReady() const { return ready; }
+
+    void playMusic();
+    void pauseMusic();
+    void stopMusic();
+    void playEffect(SoundId id, qreal volume);
+
+    static const int INIT_DELAY_MS = 200;
+    static const int MAX_QUEUED_EFFECTS = 4; // 就绪前最多保留的音效请求
+
+signals:
+    void initialized(); // 音频对象已创建（音效可能仍在解码）
+
+private slots:
+    void initialize();
+    void onPathsResolved();
+
+private:
+    enum MusicState { MusicStopped, MusicPlaying, MusicPaused };
+
+    bool started;
+    bool ready;
+    MusicState musicState;     // 就绪前只记录最后一次请求的状态
+    QVector<QPair<SoundId, qreal>> queuedEffects;
+    QFutureWatcher<QStringList> *probeWatcher;
+    SoundEffects *effects;
+    QMediaPlayer *bgmPlayer;
+    QAudioOutput *bgmAudio;
+
+    void applyMusicState();
+    static QString findSound(const QString& fileName); // 依次尝试常见位置
+};
+
+#endif
@@ -0,0 +1,179 @@
+#include "outbox.h"
+#include <QDataStream>
+#include <QSaveFile>
+#include <QUuid>
+#include <QDebug>
+
+namespace {
+const quint32 OUTBOX_MAGIC = 0x4C4C4B4F; // "LLKO"
+const quint32 ENTRY_MARKER = 0x4F425831; // "OBX1"
+const quint16 FORMAT_VERSION = 1;
+const int HEADER_SIZE = 16;       // magic, version, reserved, head
+const int HEAD_POS = 8;
+const int ENTRY_HEADER_SIZE = 24; // marker, length, checksum, key
+const qint64 COMPACT_THRESHOLD = 256 * 1024;
+
+QByteArray fileHeader(quint64 head) {
+    QByteArray header;
+    QDataStream out(&header, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << OUTBOX_MAGIC << FORMAT_VERSION << quint16(0) << head;
+    return header;
+}
+}
+
+Outbox::Outbox(const QString& path) : pending(0) {
+    file.setFileName(path);
+}
+
+Outbox::~Outbox() {
+    file.close();
+}
+
+bool Outbox::open() {
+    if (!file.open(QIODevice::ReadWrite)) {
+        qDebug() << "Failed to open outbox:" << file.errorString();
+        return false;
+    }
+
+    quint64 head = HEADER_SIZE;
+    bool valid = false;
+    if (file.size() >= HEADER_SIZE) {
+        QDataStream in(file.read(HEADER_SIZE));
+        in.setByteOrder(QDataStream::LittleEndian);
+        quint32 magic;
+        quint16 version, reserved;
+        in >> magic >> version >> reserved >> head;
+        valid = magic == OUTBOX_MAGIC && version == FORMAT_VERSION;
+    }
+    if (!valid) {
+        file.resize(0);
+        file.seek(0);
+        file.write(fileHeader(HEADER_SIZE));
+        file.flush();
+        head = HEADER_SIZE;
+    }
+
+    // 从队首扫描出未确认条目，末尾写了一半的条目直接截掉
+    refs.clear();
+    pending = 0;
+    quint64 offset = head;
+    quint64 end = file.size();
+    while (offset < end) {
+        OutboxEntry e;
+        int size;
+        if (!readEntry(offset, e, &size)) break;
+        refs.enqueue({offset, size});
+        pending += size;
+        offset += size;
+    }
+    if (offset < end) {
+        file.resize(offset);
+    }
+    compact();
+    return true;
+}
+
+bool Outbox::enqueue(const QByteArray& payload) {
+    if (payload.size() > 0xFFFF) return false;
+
+    // 超出上限时丢弃最旧的条目，保证内存和磁盘占用有界
+    int dropped = 0;
+    while (!refs.isEmpty() &&
+           (refs.size() >= MAX_ENTRIES || pending + ENTRY_HEADER_SIZE + payload.size() > MAX_BYTES)) {
+        pending -= refs.dequeue().size;
+        dropped++;
+    }
+    if (dropped > 0) {
+        qDebug() << "Outbox full, dropped" << dropped << "oldest uploads";
+        writeHead(refs.isEmpty() ? quint64(file.size()) : refs.head().offset);
+    }
+
+    QByteArray entry;
+    QDataStream e(&entry, QIODevice::WriteOnly);
+    e.setByteOrder(QDataStream::LittleEndian);
+    e << ENTRY_MARKER << quint16(payload.size()) << qChecksum(payload);
+    entry.append(QUuid::createUuid().toRfc4122());
+    entry.append(payload);
+
+    quint64 offset = file.size();
+    file.seek(offset);
+    if (file.write(entry) != entry.size()) return false;
+    file.flush();
+    refs.enqueue({offset, int(entry.size())});
+    pending += entry.size();
+    return true;
+}
+
+QVector<OutboxEntry> Outbox::peek(int max) {
+    QVector<OutboxEntry> entries;
+    for (int i = 0; i < refs.size() && i < max; i++) {
+        OutboxEntry e;
+        if (readEntry(refs[i].offset, e)) entries.append(e);
+    }
+    return entries;
+}
+
+void Outbox::ack(quint64 lastOffset) {
+    while (!refs.isEmpty() && refs.head().offset <= lastOffset) {
+        pending -= refs.dequeue().size;
+    }
+    writeHead(refs.isEmpty() ? quint64(file.size()) : refs.head().offset);
+    compact();
+}
+
+bool Outbox::readEntry(quint64 offset, OutboxEntry& e, int *entrySize) {
+    if (!file.seek(offset)) return false;
+    QByteArray head = file.read(ENTRY_HEADER_SIZE);
+    if (head.size() != ENTRY_HEADER_SIZE) return false;
+
+    QDataStream h(head);
+    h.setByteOrder(QDataStream::LittleEndian);
+    quint32 marker;
+    quint16 length, checksum;
+    h >> marker >> length >> checksum;
+    if (marker != ENTRY_MARKER) return false;
+
+    e.key = head.mid(8, 16);
+    e.offset = offset;
+    e.payload = file.read(length);
+    if (e.payload.size() != length || qChecksum(e.payload) != checksum) return false;
+    if (entrySize) *entrySize = ENTRY_HEADER_SIZE + length;
+    return true;
+}
+
+void Outbox::writeHead(quint64 head) {
+    QByteArray b;
+    QDataStream out(&b, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << head;
+    file.seek(HEAD_POS);
+    file.write(b);
+    file.flush();
+}
+
+// 已确认部分超过阈值且占文件一半以上时，把未确认条目搬到文件头部
+void Outbox::compact() {
+    quint64 head = refs.isEmpty() ? quint64(file.size()) : refs.head().offset;
+    qint64 dead = qint64(head) - HEADER_SIZE;
+    if (dead < COMPACT_THRESHOLD || dead < file.size() / 2) return;
+
+    file.seek(head);
+    QByteArray live = file.read(file.size() - head);
+    if (live.size() != file.size() - qint64(head)) return;
+
+    // 压缩后的队列先写入临时文件，再整体替换原文件；中途崩溃时原文件和队首都保持不变
+    QSaveFile compacted(file.fileName());
+    if (!compacted.open(QIODevice::WriteOnly)) return;
+    compacted.write(fileHeader(HEADER_SIZE));
+    compacted.write(live);
+    file.close(); // Windows上打开着的文件不能被替换
+    if (compacted.commit()) {
+        for (EntryRef& r : refs) {
+            r.offset -= dead;
+        }
+    }
+    if (!file.open(QIODevice::ReadWrite)) {
+        qDebug() << "Failed to reopen outbox:" << file.errorString();
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef OUTBOX_H
+#define OUTBOX_H
+#include <QFile>
+#include <QQueue>
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+// 一条待上传的数据及其幂等键
+struct OutboxEntry {
+    QByteArray key;     // 16字节UUID，服务器据此去重
+    QByteArray payload; // 紧凑JSON
+    quint64 offset;     // 在文件中的位置，确认时据此定位
+};
+
+// 持久化的上传队列（outbox.dat）。条目只追加在文件尾，确认后推进文件头中的队首位置，
+// 已确认部分过多时整体压缩。内存中只保留每条的位置和长度，条目数和文件大小都有上限，
+// 超出时丢弃最旧的条目（记录本身仍保存在本地记录存储中）。
+class Outbox {
+public:
+    explicit Outbox(const QString& path = "outbox.dat");
+    ~Outbox();
+
+    bool open();
+    bool enqueue(const QByteArray& payload); // 生成幂等键并写入磁盘
+    QVector<OutboxEntry> peek(int max);      // 队首最多max条，不出队
+    // 位置不超过lastOffset的条目已被服务器确认（或被拒绝）。按位置而不是条数确认：
+    // 发送期间队列满丢弃的旧条目不会让确认落到未发送的条目上。文件只在ack和open中压缩，
+    // 所以peek与ack之间位置不变
+    void ack(quint64 lastOffset);
+    int pendingCount() const { return refs.size(); }
+    qint64 pendingBytes() const { return pending; }
+
+    static const int MAX_ENTRIES = 10000;
+    static const qint64 MAX_BYTES = 4 * 1024 * 1024;
+
+private:
+    struct EntryRef {
+        quint64 offset;
+        int size;
+    };
+
+    QFile file;
+    QQueue<EntryRef> refs;
+    qint64 pending; // 未确认条目占用的字节数
+
+    bool readEntry(quint64 offset, OutboxEntry& e, int *entrySize = nullptr);
+    void writeHead(quint64 head);
+    void compact();
+};
+
+#endif
@@ -8,17 +8,33 @@ RecordDialog::RecordDialog(QWidget *parent) : QDialog(parent) {
     setWindowTitle("Game Records");
     setMinimumSize(600, 400);
     
-    table = new QTableWidget(this);
-    table->setColumnCount(5);
-    table->setHorizontalHeaderLabels({"Score", "Time Left", "Player", "Difficulty", "Date/Time"});
+    model = new RecordTableModel(this);
+    table = new QTableView(this);
+    table->setModel(model);
     table->horizontalHeader()->setStretchLastSection(true);
+    // 行高固定、列宽只按少量行估算，避免逐格测量
+    table->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    table->horizontalHeader()->setResizeContentsPrecision(50);
     table->setSelectionBehavior(QAbstractItemView::SelectRows);
     table->setEditTriggers(QAbstractItemView::NoEditTriggers);
     
     refreshBtn = new QPushButton("Refresh", this);
     cloudBtn = new QPushButton("Load from Cloud", this);
     
+    difficultyCombo = new QComboBox(this);
+    difficultyCombo->addItems({"🌱 Beginner", "⭐ Primary", "🔥 Intermediate", "💀 Advanced"});
+    difficultyCombo->setCurrentIndex(1);
+    rankLabel = new QLabel(this);
+    playerEdit = new QLineEdit(this);
+    playerEdit->setPlaceholderText("Player");
+    playerEdit->setClearButtonEnabled(true);
+    table->horizontalHeader()->setSortIndicator(0, Qt::DescendingOrder);
+    table->setSortingEnabled(true); // 点击表头时由模型交给存储后端排序
+    
     QHBoxLayout *buttonLayout = new QHBoxLayout;
+    buttonLayout->addWidget(difficultyCombo);
+    buttonLayout->addWidget(playerEdit);
+    buttonLayout->addWidget(rankLabel);
     buttonLayout->addStretch();
     buttonLayout->addWidget(refreshBtn);
     buttonLayout->addWidget(cloudBtn);
@@ -30,24 +46,39 @@ RecordDialog::RecordDialog(QWidget *parent) : QDialog(parent) {
     
     connect(refreshBtn, &QPushButton::clicked, this, &RecordDialog::refreshRecords);
     connect(cloudBtn, &QPushButton::clicked, this, &RecordDialog::loadCloudRecords);
+    connect(difficultyCombo, &QComboBox::currentIndexChanged, this, &RecordDialog::refreshRecords);
+    connect(playerEdit, &QLineEdit::editingFinished, this, &RecordDialog::refreshRecords);
+    connect(RecordManager::instance(), &RecordManager::loadCompleted, this, &RecordDialog::onCloudRecordsLoaded);
     
+    // 之前加载过云端记录时先显示缓存，再在后台做一次条件请求确认
+    if (RecordManager::hasCloudCache()) {
+        model->setCloudRecords(RecordManager::cachedCloudRecords());
+        RecordManager::loadFromCloud();
+    }
     populateTable();
 }
 
 void RecordDialog::populateTable() {
-    auto records = RecordManager::loadRecords();
-    table->setRowCount(records.size());
-    
-    for (int i = 0; i < records.size(); i++) {
-        const Record& r = records[i];
-        table->setItem(i, 0, new QTableWidgetItem(QString::number(r.score)));
-        table->setItem(i, 1, new QTableWidgetItem(QString::number(r.time)));
-        table->setItem(i, 2, new QTableWidgetItem(r.playerName));
-        table->setItem(i, 3, new QTableWidgetItem(r.difficulty));
-        table->setItem(i, 4, new QTableWidgetItem(r.dateTime));
+    model->setFilter(difficultyCombo->currentText(), playerEdit->text().trimmed());
+    if (model->canFetchMore(QModelIndex())) {
+        model->fetchMore(QModelIndex());
     }
-    
     table->resizeColumnsToContents();
+    updateRankLabel();
+}
+
+void RecordDialog::updateRankLabel() {
+    QString difficulty = difficultyCombo->currentText();
+    int total = RecordManager::recordCount(difficulty);
+    Record latest;
+    if (!playerEdit->text().trimmed().isEmpty()) {
+        rankLabel->setText(QString("%1 games").arg(model->totalCount()));
+    } else if (RecordManager::latestRecord(difficulty, latest)) {
+        rankLabel->setText(QString("Last game: #%1 of %2")
+                           .arg(RecordManager::rankOf(latest.score, difficulty)).arg(total));
+    } else {
+        rankLabel->setText(QString("%1 games").arg(total));
+    }
 }
 
 void RecordDialog::refreshRecords() {
@@ -55,9 +86,10 @@ void RecordDialog::refreshRecords() {
 }
 
 void RecordDialog::loadCloudRecords() {
-    RecordManager::loadFromCloud();
-    // 实际应用中应该连接信号来更新表格
-    // connect(RecordManager::instance(), &RecordManager::loadCompleted, 
-    //         this, [this](const QVector<Record>& records) { ... });
+    RecordManager::loadFromCloud(); // 结果经loadCompleted回到onCloudRecordsLoaded
+}
+
+void RecordDialog::onCloudRecordsLoaded(const QVector<Record>& records) {
+    model->setCloudRecords(records);
     populateTable();
 }
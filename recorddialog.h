@@ -1,8 +1,12 @@
 #ifndef RECORDDIALOG_H
 #define RECORDDIALOG_H
 #include <QDialog>
-#include <QTableWidget>
+#include <QTableView>
 #include <QPushButton>
+#include <QComboBox>
+#include <QLabel>
+#include <QLineEdit>
+#include "recordtablemodel.h"
 
 class RecordDialog: public QDialog {
     Q_OBJECT
@@ -12,12 +16,18 @@ public:
 private slots:
     void refreshRecords();
     void loadCloudRecords();
+    void onCloudRecordsLoaded(const QVector<Record>& records);
     
 private:
-    QTableWidget *table;
+    QTableView *table;
+    RecordTableModel *model; // 按需分页读取，不一次加载全部记录
     QPushButton *refreshBtn;
     QPushButton *cloudBtn;
+    QComboBox *difficultyCombo; // 排行榜按难度分开
+    QLabel *rankLabel;          // 最近一局的名次
+    QLineEdit *playerEdit;      // 按玩家过滤
     void populateTable();
+    void updateRankLabel();
 };
 
 #endif
@@ -0,0 +1,165 @@
+#include "recordioworker.h"
+#include "recordstorage.h"
+#include "cloudsync.h"
+#include "cloudleaderboard.h"
+#include "telemetry.h"
+#include <QNetworkAccessManager>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QFile>
+#include <QDebug>
+
+namespace {
+const quint32 BOARD_MAGIC = 0x4C4C4B42; // "LLKB"
+const quint16 BOARD_VERSION = 1;
+const int CATCH_UP_BATCH = 256;
+
+void addToBoard(QHash<int, Leaderboard>& boards, const Record& r) {
+    int code = RecordStorage::difficultyCode(r.difficulty);
+    auto it = boards.find(code);
+    if (it == boards.end()) it = boards.insert(code, Leaderboard(RecordManager::LEADERBOARD_SIZE));
+    it->insert(r);
+}
+}
+
+RecordIOWorker::RecordIOWorker(RecordStorage* store, QObject* parent)
+    : QObject(parent), store(store), nam(nullptr), cloudSync(nullptr), cloudBoard(nullptr),
+      storeOpen(false), flushScheduled(false)
+{
+}
+
+void RecordIOWorker::start() {
+    // 打开存储在任何排队的保存请求之前完成
+    openStore();
+    // 网络对象属于创建它的线程，所以在这里而不是构造函数中创建
+    nam = new QNetworkAccessManager(this);
+    cloudSync = new CloudSync(store, nam, this);
+    connect(cloudSync, &CloudSync::syncFinished, this, &RecordIOWorker::syncFinished);
+    cloudBoard = new CloudLeaderboard(nam, "records.cloud", this);
+    connect(cloudBoard, &CloudLeaderboard::loaded, this, &RecordIOWorker::cloudLoaded);
+    if (cloudBoard->hasCache()) {
+        emit cloudLoaded(cloudBoard->cached(), false);
+    }
+}
+
+void RecordIOWorker::openStore() {
+    storeOpen = store->open();
+    if (!storeOpen) {
+        qDebug() << "Record store unavailable, records will not be saved";
+    }
+    // 排行榜优先读取上次退出时保存的文件，缺失或与存储对不上时才从索引重建
+    if (!storeOpen || !loadLeaderboards()) {
+        rebuildLeaderboards();
+    }
+    emit leaderboardsLoaded(boards);
+}
+
+bool RecordIOWorker::loadLeaderboards() {
+    QFile f(store->name() + ".board");
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    QDataStream in(&f);
+    in.setByteOrder(QDataStream::LittleEndian);
+    quint32 magic;
+    quint16 version;
+    quint64 offset;
+    qint32 n;
+    in >> magic >> version;
+    if (magic != BOARD_MAGIC || version != BOARD_VERSION) return false;
+    in >> offset >> n;
+    if (in.status() != QDataStream::Ok || n < 0 || offset > store->endOffset()) return false;
+
+    QHash<int, Leaderboard> loaded;
+    for (int i = 0; i < n; i++) {
+        qint32 code;
+        in >> code;
+        Leaderboard board(RecordManager::LEADERBOARD_SIZE);
+        if (!board.read(in)) return false;
+        loaded.insert(code, board);
+    }
+
+    // 保存之后追加的记录（例如上次异常退出）从日志补上，只读这一段
+    quint64 end = store->endOffset();
+    while (offset < end) {
+        QVector<Record> rs;
+        QVector<quint32> seqs;
+        quint64 next;
+        if (store->readFrom(offset, CATCH_UP_BATCH, rs, seqs, next) == 0) break;
+        for (const Record& r : rs) addToBoard(loaded, r);
+        offset = next;
+    }
+
+    // 总数对不上说明文件与存储不一致（换了存储、写入失败等），改为重建
+    int total = 0;
+    for (const Leaderboard& board : loaded) total += board.count();
+    if (total != store->count()) return false;
+    boards = loaded;
+    return true;
+}
+
+void RecordIOWorker::rebuildLeaderboards() {
+    boards.clear();
+    for (int code : store->difficultyCodes()) {
+        Leaderboard board(RecordManager::LEADERBOARD_SIZE);
+        board.build(store->top(RecordManager::LEADERBOARD_SIZE, code), store->scores(code));
+        boards.insert(code, board);
+    }
+}
+
+void RecordIOWorker::saveLeaderboards() {
+    QSaveFile f(store->name() + ".board");
+    if (!f.open(QIODevice::WriteOnly)) return;
+    QDataStream out(&f);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << BOARD_MAGIC << BOARD_VERSION << quint64(store->endOffset()) << qint32(boards.size());
+    for (auto it = boards.constBegin(); it != boards.constEnd(); ++it) {
+        out << qint32(it.key());
+        it.value().write(out);
+    }
+    f.commit();
+}
+
+void RecordIOWorker::save(const Record& r) {
+    pendingSaves.append(r);
+    if (flushScheduled) return;
+    // 排在已入队的保存请求之后执行，同一批到达的记录一次写入
+    flushScheduled = true;
+    QMetaObject::invokeMethod(this, &RecordIOWorker::flushSaves, Qt::QueuedConnection);
+}
+
+void RecordIOWorker::flushSaves() {
+    flushScheduled = false;
+    if (pendingSaves.isEmpty()) return;
+    Telemetry::Scope telemetry(Telemetry::RECORD_IO);
+    telemetry.setArg(pendingSaves.size());
+    if (store->appendBatch(pendingSaves)) {
+        for (const Record& r : pendingSaves) addToBoard(boards, r);
+    } else {
+        qDebug() << "Failed to append" << pendingSaves.size() << "records";
+    }
+    pendingSaves.clear();
+    if (cloudSync) cloudSync->recordAdded();
+}
+
+void RecordIOWorker::syncNow() {
+    flushSaves();
+    if (cloudSync) cloudSync->flush();
+}
+
+void RecordIOWorker::fetchCloud() {
+    if (cloudBoard) cloudBoard->fetch(cloudSync->getEndpoint());
+}
+
+void RecordIOWorker::setEndpoint(const QUrl& url) {
+    if (cloudSync) cloudSync->setEndpoint(url);
+}
+
+void RecordIOWorker::shutdown() {
+    flushSaves();
+    if (storeOpen) saveLeaderboards();
+    delete cloudBoard;
+    delete cloudSync;
+    delete nam;
+    cloudBoard = nullptr;
+    cloudSync = nullptr;
+    nam = nullptr;
+}
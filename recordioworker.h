@@ -0,0 +1,54 @@
+#ifndef RECORDIOWORKER_H
+#define RECORDIOWORKER_H
+#include <QObject>
+#include <QUrl>
+#include <QVector>
+#include <QHash>
+#include "recordmanager.h"
+#include "leaderboard.h"
+
+class RecordStorage;
+class CloudSync;
+class CloudLeaderboard;
+class QNetworkAccessManager;
+
+// 运行在独立I/O线程上的记录工作者：保存、上传和云端排行榜下载都在这里完成。
+// 请求经排队的信号槽调用送达，连续到达的多次保存合并为一次批量写入。
+class RecordIOWorker : public QObject {
+    Q_OBJECT
+public:
+    explicit RecordIOWorker(RecordStorage* store, QObject* parent = nullptr);
+
+public slots:
+    void start();                       // 线程启动后在I/O线程上打开存储、建立排行榜并创建网络对象
+    void save(const Record& r);
+    void syncNow();
+    void fetchCloud();
+    void setEndpoint(const QUrl& url);
+    void shutdown();                    // 写完尚未落盘的记录并释放网络对象
+
+signals:
+    void leaderboardsLoaded(const QHash<int, Leaderboard>& boards); // 按难度代码
+    void syncFinished(bool success);
+    void cloudLoaded(const QVector<Record>& records, bool changed);
+
+private slots:
+    void flushSaves();
+
+private:
+    void openStore();
+    bool loadLeaderboards();
+    void rebuildLeaderboards();
+    void saveLeaderboards();
+
+    RecordStorage* store;
+    QNetworkAccessManager* nam;
+    CloudSync* cloudSync;
+    CloudLeaderboard* cloudBoard;
+    QHash<int, Leaderboard> boards; // 与存储同步更新，退出时写入store->name()+".board"
+    bool storeOpen;
+    QVector<Record> pendingSaves;
+    bool flushScheduled;
+};
+
+#endif
@@ -1,21 +1,71 @@
 #include "recordmanager.h"
-#include <QFile>
-#include <QTextStream>
-#include <QNetworkRequest>
-#include <QNetworkReply>
-#include <QJsonDocument>
-#include <QJsonArray>
-#include <QJsonObject>
+#include "recordstore.h"
+#include "sqlrecordstore.h"
+#include "leaderboard.h"
+#include "recordioworker.h"
 #include <QDateTime>
 #include <QDebug>
 #include <QStandardPaths>
 #include <QDir>
+#include <QThread>
+#include <QCoreApplication>
 #include <algorithm>
 
 RecordManager* RecordManager::inst = nullptr;
 
-RecordManager::RecordManager(QObject* parent) : QObject(parent), playerName("Player") {
-    networkManager = new QNetworkAccessManager(this);
+RecordManager::RecordManager(QObject* parent)
+    : QObject(parent), playerName("Player"), leaderboardsReady(false)
+{
+    // 存储由I/O线程写入、界面线程分页读取，外面包一层锁。
+    // 这里只创建对象，打开存储和建立排行榜都在I/O线程上完成
+    if (qgetenv("LLK_RECORD_BACKEND") == "sqlite") {
+        store = new LockedRecordStorage(new SqlRecordStore("records"));
+    } else {
+        store = new LockedRecordStorage(new RecordStore("records"));
+    }
+    
+    cloudCacheValid = false;
+    
+    // 写文件和网络请求都在I/O线程上进行，游戏结束时不等待磁盘
+    ioThread = new QThread(this);
+    ioThread->setObjectName("RecordIO");
+    worker = new RecordIOWorker(store);
+    worker->moveToThread(ioThread);
+    connect(ioThread, &QThread::started, worker, &RecordIOWorker::start);
+    connect(ioThread, &QThread::finished, worker, &QObject::deleteLater);
+    connect(worker, &RecordIOWorker::leaderboardsLoaded, this, [this](const QHash<int, Leaderboard>& boards) {
+        onLeaderboardsLoaded(boards);
+    });
+    connect(worker, &RecordIOWorker::syncFinished, this, &RecordManager::syncCompleted);
+    connect(worker, &RecordIOWorker::cloudLoaded, this, [this](const QVector<Record>& records, bool) {
+        cloudRecords = records;
+        cloudCacheValid = true;
+        emit loadCompleted(records);
+    });
+    connect(qApp, &QCoreApplication::aboutToQuit, this, &RecordManager::shutdown);
+    ioThread->start();
+}
+
+void RecordManager::shutdown() {
+    if (!ioThread->isRunning()) return;
+    // 退出前把排队中的记录写完
+    QMetaObject::invokeMethod(worker, &RecordIOWorker::shutdown, Qt::BlockingQueuedConnection);
+    ioThread->quit();
+    ioThread->wait();
+}
+
+void RecordManager::onLeaderboardsLoaded(const QHash<int, Leaderboard>& boards) {
+    qDeleteAll(leaderboards);
+    leaderboards.clear();
+    for (auto it = boards.constBegin(); it != boards.constEnd(); ++it) {
+        leaderboards.insert(it.key(), new Leaderboard(it.value()));
+    }
+    // 送达前保存的记录排在打开存储之后写入，不在送来的排行榜中
+    for (const Record& r : earlySaves) {
+        leaderboardFor(r.difficulty)->add(r);
+    }
+    earlySaves.clear();
+    leaderboardsReady = true;
 }
 
 RecordManager* RecordManager::instance() {
@@ -28,145 +78,92 @@ RecordManager* RecordManager::instance() {
 void RecordManager::saveRecord(int score, int time, const QString& playerName, 
                                const QString& difficulty) {
     instance()->saveRecordLocal(score, time, playerName, difficulty);
-    
-    // 同时尝试同步到云端
-    syncToCloud();
 }
 
 void RecordManager::saveRecordLocal(int score, int time, const QString& playerName, 
                                     const QString& difficulty) {
-    QFile f("records.txt");
-    if (f.open(QIODevice::Append | QIODevice::Text)) {
-        QTextStream out(&f);
-        QString dateTime = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss");
-        out << score << " " << time << " " << playerName << " " 
-            << difficulty << " " << dateTime << "\n";
-        f.close();
+    Record r;
+    r.score = score;
+    r.time = time;
+    r.playerName = playerName;
+    r.difficulty = difficulty;
+    r.dateTime = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss");
+    r.id = -1;
+    // 排行榜立即更新；写入和上传排队交给I/O线程，之后加入待同步批次
+    leaderboardFor(difficulty)->add(r);
+    if (!leaderboardsReady) earlySaves.append(r);
+    QMetaObject::invokeMethod(worker, [w = worker, r]() { w->save(r); }, Qt::QueuedConnection);
+}
+
+Leaderboard* RecordManager::leaderboardFor(const QString& difficulty) {
+    int code = RecordStorage::difficultyCode(difficulty);
+    Leaderboard* board = leaderboards.value(code);
+    if (!board) {
+        board = new Leaderboard(LEADERBOARD_SIZE);
+        leaderboards.insert(code, board);
     }
+    return board;
+}
+
+QVector<Record> RecordManager::leaderboard(const QString& difficulty) {
+    return instance()->leaderboardFor(difficulty)->entries();
+}
+
+int RecordManager::rankOf(int score, const QString& difficulty) {
+    return instance()->leaderboardFor(difficulty)->rankOf(score);
+}
+
+int RecordManager::recordCount(const QString& difficulty) {
+    return instance()->leaderboardFor(difficulty)->count();
+}
+
+bool RecordManager::latestRecord(const QString& difficulty, Record& r) {
+    Leaderboard* board = instance()->leaderboardFor(difficulty);
+    if (!board->hasLatest()) return false;
+    r = board->latest();
+    return true;
 }
 
 QVector<Record> RecordManager::loadRecords() {
     return instance()->loadRecordsLocal();
 }
 
+QVector<Record> RecordManager::loadTopRecords(int n, const QString& difficulty) {
+    int code = difficulty.isEmpty() ? -1 : RecordStorage::difficultyCode(difficulty);
+    return instance()->store->top(n, code);
+}
+
+int RecordManager::queryCount(const RecordQuery& q) {
+    return instance()->store->queryCount(q);
+}
+
+QVector<Record> RecordManager::queryRecords(const RecordQuery& q, int offset, int limit) {
+    return instance()->store->query(q, offset, limit);
+}
+
 QVector<Record> RecordManager::loadRecordsLocal() {
-    QVector<Record> rs;
-    QFile f("records.txt");
-    if (f.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QTextStream in(&f);
-        while (!in.atEnd()) {
-            QString line = in.readLine();
-            QStringList parts = line.split(" ");
-            if (parts.size() >= 2) {
-                Record r;
-                r.score = parts[0].toInt();
-                r.time = parts[1].toInt();
-                r.playerName = parts.size() > 2 ? parts[2] : "Player";
-                r.difficulty = parts.size() > 3 ? parts[3] : "Primary";
-                r.dateTime = parts.size() > 4 ? parts.mid(4).join(" ") : 
-                             QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss");
-                r.id = -1; // 本地记录没有ID
-            rs.push_back(r);
-        }
-    }
-        f.close();
-    }
-    
-    // 按分数排序
-    std::sort(rs.begin(), rs.end(), [](const Record& a, const Record& b) {
-        return a.score > b.score;
-    });
-    
-    return rs;
+    // 索引已按分数排好序，不需要解析和排序
+    return store->all();
 }
 
 void RecordManager::syncToCloud() {
-    // 注意：这里使用模拟的云端API
-    // 实际使用时需要替换为真实的API端点
-    // 例如使用Firebase, Supabase, 或其他后端服务
-    
-    QVector<Record> localRecords = instance()->loadRecordsLocal();
-    
-    // 创建JSON数据
-    QJsonArray recordsArray;
-    for (const Record& r : localRecords) {
-        QJsonObject recordObj;
-        recordObj["score"] = r.score;
-        recordObj["time"] = r.time;
-        recordObj["playerName"] = r.playerName;
-        recordObj["difficulty"] = r.difficulty;
-        recordObj["dateTime"] = r.dateTime;
-        recordsArray.append(recordObj);
-    }
-    
-    QJsonObject root;
-    root["records"] = recordsArray;
-    QJsonDocument doc(root);
-    
-    // 发送到云端API
-    // 这里使用一个示例API，实际使用时需要替换
-    QNetworkRequest request(QUrl("https://your-api-endpoint.com/records"));
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    
-    QNetworkReply* reply = instance()->networkManager->post(request, doc.toJson());
-    QObject::connect(reply, &QNetworkReply::finished, instance(), 
-                    &RecordManager::onSyncFinished);
-    
-    // 如果没有网络连接或API不可用，静默失败（本地已保存）
-    // 实际应用中可以添加错误处理
-}
-
-void RecordManager::onSyncFinished() {
-    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
-    if (reply) {
-        bool success = (reply->error() == QNetworkReply::NoError);
-        if (success) {
-            qDebug() << "Records synced to cloud successfully";
-        } else {
-            qDebug() << "Failed to sync to cloud:" << reply->errorString();
-        }
-        emit instance()->syncCompleted(success);
-        reply->deleteLater();
-    }
+    // 只上传高水位之后的记录，失败时CloudSync自行退避重试
+    QMetaObject::invokeMethod(instance()->worker, &RecordIOWorker::syncNow, Qt::QueuedConnection);
+}
+
+void RecordManager::setCloudEndpoint(const QUrl& url) {
+    RecordIOWorker* w = instance()->worker;
+    QMetaObject::invokeMethod(w, [w, url]() { w->setEndpoint(url); }, Qt::QueuedConnection);
 }
 
 void RecordManager::loadFromCloud() {
-    // 从云端加载记录
-    QNetworkRequest request(QUrl("https://your-api-endpoint.com/records"));
-    QNetworkReply* reply = instance()->networkManager->get(request);
-    QObject::connect(reply, &QNetworkReply::finished, instance(), 
-                    &RecordManager::onLoadFinished);
+    QMetaObject::invokeMethod(instance()->worker, &RecordIOWorker::fetchCloud, Qt::QueuedConnection);
 }
 
-void RecordManager::onLoadFinished() {
-    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
-    QVector<Record> records;
-    
-    if (reply && reply->error() == QNetworkReply::NoError) {
-        QByteArray data = reply->readAll();
-        QJsonDocument doc = QJsonDocument::fromJson(data);
-        
-        if (doc.isObject()) {
-            QJsonObject root = doc.object();
-            QJsonArray recordsArray = root["records"].toArray();
-            
-            for (const QJsonValue& value : recordsArray) {
-                QJsonObject obj = value.toObject();
-                Record r;
-                r.id = obj["id"].toInt();
-                r.score = obj["score"].toInt();
-                r.time = obj["time"].toInt();
-                r.playerName = obj["playerName"].toString();
-                r.difficulty = obj["difficulty"].toString();
-                r.dateTime = obj["dateTime"].toString();
-                records.append(r);
-            }
-        }
-    }
-    
-    emit instance()->loadCompleted(records);
-    if (reply) {
-        reply->deleteLater();
-    }
+bool RecordManager::hasCloudCache() {
+    return instance()->cloudCacheValid;
 }
 
+QVector<Record> RecordManager::cachedCloudRecords() {
+    return instance()->cloudRecords;
+}
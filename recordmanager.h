@@ -3,7 +3,9 @@
 #include <QVector>
 #include <QString>
 #include <QObject>
+#include <QUrl>
 #include <QNetworkAccessManager>
+#include <QHash>
 
 struct Record {
     int score;
@@ -14,6 +16,12 @@ struct Record {
     int id; // 云端ID
 };
 
+class RecordStorage;
+struct RecordQuery;
+class Leaderboard;
+class RecordIOWorker;
+class QThread;
+
 class RecordManager : public QObject {
     Q_OBJECT
     
@@ -22,8 +30,19 @@ public:
     static void saveRecord(int score, int time, const QString& playerName = "Player", 
                           const QString& difficulty = "Primary");
     static QVector<Record> loadRecords();
-    static void syncToCloud();
-    static void loadFromCloud();
+    static QVector<Record> loadTopRecords(int n, const QString& difficulty = QString()); // 只读取前n条
+    static const int LEADERBOARD_SIZE = 100;
+    static QVector<Record> leaderboard(const QString& difficulty); // 该难度的前LEADERBOARD_SIZE名
+    static int rankOf(int score, const QString& difficulty);       // O(log S)
+    static int recordCount(const QString& difficulty);
+    static bool latestRecord(const QString& difficulty, Record& r); // 本次运行最近一局
+    static void syncToCloud(); // 立即上传尚未确认的记录
+    static void loadFromCloud(); // 条件请求，结果未变时只有一次304往返
+    static bool hasCloudCache();
+    static QVector<Record> cachedCloudRecords();
+    static void setCloudEndpoint(const QUrl& url); // 例如指向本地测试服务器
+    static int queryCount(const RecordQuery& q);
+    static QVector<Record> queryRecords(const RecordQuery& q, int offset, int limit); // 过滤排序后的一页
     
     void setPlayerName(const QString& name) { playerName = name; }
     QString getPlayerName() const { return playerName; }
@@ -33,18 +52,26 @@ signals:
     void loadCompleted(const QVector<Record>& records);
     
 private slots:
-    void onSyncFinished();
-    void onLoadFinished();
+    void shutdown(); // 应用退出时等待I/O线程写完
     
 private:
     RecordManager(QObject* parent = nullptr);
     static RecordManager* inst;
     QString playerName;
-    QNetworkAccessManager* networkManager;
+    RecordStorage* store; // 二进制日志，或设置LLK_RECORD_BACKEND=sqlite时为SQLite
+    QThread* ioThread;
+    RecordIOWorker* worker; // 在ioThread上保存、上传、下载云端排行榜
+    QVector<Record> cloudRecords; // 最近一次得到的云端排行榜
+    bool cloudCacheValid;
+    QHash<int, Leaderboard*> leaderboards; // 按难度代码，保存时增量更新
+    bool leaderboardsReady;                // I/O线程建好排行榜之前为false
+    QVector<Record> earlySaves;            // 排行榜送达前保存的记录，送达后补入
     
     void saveRecordLocal(int score, int time, const QString& playerName, 
                         const QString& difficulty);
     QVector<Record> loadRecordsLocal();
+    void onLeaderboardsLoaded(const QHash<int, Leaderboard>& boards);
+    Leaderboard* leaderboardFor(const QString& difficulty);
 };
 
 #endif
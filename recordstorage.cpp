@@ -0,0 +1,90 @@
+#include "recordstorage.h"
+
+bool RecordStorage::appendBatch(const QVector<Record>& rs) {
+    bool ok = true;
+    for (const Record& r : rs) {
+        ok = append(r) && ok;
+    }
+    return ok;
+}
+
+int RecordStorage::difficultyCode(const QString& difficulty) {
+    // 难度字符串来自下拉框文字（可能带图标），按名称识别
+    if (difficulty.contains("Beginner", Qt::CaseInsensitive)) return 0;
+    if (difficulty.contains("Primary", Qt::CaseInsensitive)) return 1;
+    if (difficulty.contains("Intermediate", Qt::CaseInsensitive)) return 2;
+    if (difficulty.contains("Advanced", Qt::CaseInsensitive)) return 3;
+    return 255;
+}
+
+bool RecordStorage::matches(const Record& r, const RecordQuery& q) {
+    if (!q.difficulty.isEmpty() && difficultyCode(r.difficulty) != difficultyCode(q.difficulty)) return false;
+    if (!q.player.isEmpty() && r.playerName != q.player) return false;
+    return true;
+}
+
+bool RecordStorage::lessThan(const Record& a, const Record& b, RecordQuery::Column column) {
+    switch (column) {
+        case RecordQuery::Score: return a.score < b.score;
+        case RecordQuery::Time: return a.time < b.time;
+        case RecordQuery::Player: return a.playerName < b.playerName;
+        case RecordQuery::Difficulty: return a.difficulty < b.difficulty;
+        case RecordQuery::DateTime: return a.dateTime < b.dateTime;
+    }
+    return false;
+}
+
+bool LockedRecordStorage::open() {
+    QMutexLocker locker(&mutex);
+    return inner->open();
+}
+
+bool LockedRecordStorage::append(const Record& r) {
+    QMutexLocker locker(&mutex);
+    return inner->append(r);
+}
+
+bool LockedRecordStorage::appendBatch(const QVector<Record>& rs) {
+    QMutexLocker locker(&mutex);
+    return inner->appendBatch(rs);
+}
+
+int LockedRecordStorage::count() const {
+    QMutexLocker locker(&mutex);
+    return inner->count();
+}
+
+QVector<Record> LockedRecordStorage::top(int n, int difficultyCode) {
+    QMutexLocker locker(&mutex);
+    return inner->top(n, difficultyCode);
+}
+
+QList<int> LockedRecordStorage::difficultyCodes() const {
+    QMutexLocker locker(&mutex);
+    return inner->difficultyCodes();
+}
+
+QVector<qint32> LockedRecordStorage::scores(int difficultyCode) const {
+    QMutexLocker locker(&mutex);
+    return inner->scores(difficultyCode);
+}
+
+int LockedRecordStorage::queryCount(const RecordQuery& q) {
+    QMutexLocker locker(&mutex);
+    return inner->queryCount(q);
+}
+
+QVector<Record> LockedRecordStorage::query(const RecordQuery& q, int offset, int limit) {
+    QMutexLocker locker(&mutex);
+    return inner->query(q, offset, limit);
+}
+
+quint64 LockedRecordStorage::endOffset() const {
+    QMutexLocker locker(&mutex);
+    return inner->endOffset();
+}
+
+int LockedRecordStorage::readFrom(quint64 offset, int max, QVector<Record>& out, QVector<quint32>& seqs, quint64& next) {
+    QMutexLocker locker(&mutex);
+    return inner->readFrom(offset, max, out, seqs, next);
+}
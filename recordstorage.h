@@ -0,0 +1,72 @@
+#ifndef RECORDSTORAGE_H
+#define RECORDSTORAGE_H
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include "recordmanager.h"
+
+// 记录查询条件：可按难度、玩家过滤，按任意一列排序，结果分页读取
+struct RecordQuery {
+    enum Column { Score, Time, Player, Difficulty, DateTime }; // 与记录表格的列顺序一致
+    QString difficulty; // 空表示全部难度
+    QString player;     // 空表示全部玩家
+    Column sortColumn = Score;
+    bool descending = true;
+
+    bool isDefaultOrder() const { return sortColumn == Score && descending && player.isEmpty(); }
+    bool operator==(const RecordQuery& o) const {
+        return difficulty == o.difficulty && player == o.player && sortColumn == o.sortColumn && descending == o.descending;
+    }
+};
+
+// 记录存储后端接口。readFrom/endOffset使用后端自己的位置游标（二进制日志为文件偏移，
+// SQLite为行号），只保证单调递增，供上传队列按写入顺序读取新记录。
+class RecordStorage {
+public:
+    virtual ~RecordStorage() {}
+
+    virtual bool open() = 0;
+    virtual QString name() const = 0; // 用于派生同步状态等附属文件名
+    virtual bool append(const Record& r) = 0;
+    virtual bool appendBatch(const QVector<Record>& rs);
+    virtual int count() const = 0;
+    virtual QVector<Record> top(int n, int difficultyCode = -1) = 0;
+    QVector<Record> all() { return top(-1); }
+    virtual QList<int> difficultyCodes() const = 0;
+    virtual QVector<qint32> scores(int difficultyCode) const = 0;
+    virtual int queryCount(const RecordQuery& q) = 0;
+    virtual QVector<Record> query(const RecordQuery& q, int offset, int limit) = 0;
+    virtual quint64 endOffset() const = 0;
+    virtual int readFrom(quint64 offset, int max, QVector<Record>& out, QVector<quint32>& seqs, quint64& next) = 0;
+
+    static int difficultyCode(const QString& difficulty); // 0..3对应Difficulty枚举，其余为255
+    static bool matches(const Record& r, const RecordQuery& q);
+    static bool lessThan(const Record& a, const Record& b, RecordQuery::Column column);
+};
+
+// 给任意后端加一把锁：I/O线程写入、上传队列读取与界面的分页查询可以共用同一个存储
+class LockedRecordStorage : public RecordStorage {
+public:
+    explicit LockedRecordStorage(RecordStorage* inner) : inner(inner) {}
+    ~LockedRecordStorage() { delete inner; }
+
+    bool open() override;
+    QString name() const override { return inner->name(); }
+    bool append(const Record& r) override;
+    bool appendBatch(const QVector<Record>& rs) override;
+    int count() const override;
+    QVector<Record> top(int n, int difficultyCode = -1) override;
+    QList<int> difficultyCodes() const override;
+    QVector<qint32> scores(int difficultyCode) const override;
+    int queryCount(const RecordQuery& q) override;
+    QVector<Record> query(const RecordQuery& q, int offset, int limit) override;
+    quint64 endOffset() const override;
+    int readFrom(quint64 offset, int max, QVector<Record>& out, QVector<quint32>& seqs, quint64& next) override;
+
+private:
+    RecordStorage* inner;
+    mutable QMutex mutex;
+};
+
+#endif
@@ -0,0 +1,485 @@
+#include "recordstore.h"
+#include <QDataStream>
+#include <QTextStream>
+#include <QDateTime>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+const quint32 LOG_MAGIC = 0x4C4C4B52;    // "LLKR"
+const quint32 IDX_MAGIC = 0x4C4C4B49;    // "LLKI"
+const quint32 ENTRY_MARKER = 0x52454331; // "REC1"
+const quint16 FORMAT_VERSION = 2;
+const int LOG_HEADER_SIZE = 16;   // magic, version, reserved, reserved
+const int ENTRY_HEADER_SIZE = 16; // marker, seq, score, length, checksum
+const int IDX_HEADER_SIZE = 24;   // magic, version, reserved, logSize, sortedCount, nextSeq
+const int IDX_ENTRY_SIZE = 16;    // offset, score, difficulty, reserved
+const int IDX_LOGSIZE_POS = 8;
+const int IDX_NEXTSEQ_POS = 20;
+const int INDEX_REWRITE_THRESHOLD = 4096; // 索引文件追加的尾部超过这么多条时整体重写
+
+// 条目校验和覆盖头部中标记之后的序号、分数、长度，以及负载
+quint16 entryChecksum(const QByteArray& head, const QByteArray& payload) {
+    return qChecksum(head.mid(4, 10) + payload);
+}
+
+QByteArray encodeU64(quint64 v) {
+    QByteArray b;
+    QDataStream out(&b, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << v;
+    return b;
+}
+
+QByteArray encodeU32(quint32 v) {
+    QByteArray b;
+    QDataStream out(&b, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << v;
+    return b;
+}
+}
+
+RecordStore::RecordStore(const QString& basePath)
+    : basePath(basePath), mergedValid(false), sortedValid(false), sortedLoaded(false), sortedCount(0),
+      unsortedOnDisk(0), total(0), nextSeq(0)
+{
+}
+
+RecordStore::~RecordStore() {
+    log.close();
+    idx.close();
+}
+
+bool RecordStore::open() {
+    QString logPath = basePath + ".dat";
+    bool fresh = !QFile::exists(logPath);
+
+    log.setFileName(logPath);
+    if (!log.open(QIODevice::ReadWrite)) {
+        qDebug() << "Failed to open record log:" << log.errorString();
+        return false;
+    }
+    if (fresh || log.size() < LOG_HEADER_SIZE) {
+        QByteArray header;
+        QDataStream out(&header, QIODevice::WriteOnly);
+        out.setByteOrder(QDataStream::LittleEndian);
+        out << LOG_MAGIC << FORMAT_VERSION << quint16(0) << quint64(0);
+        log.resize(0);
+        log.seek(0);
+        log.write(header);
+        log.flush();
+        fresh = true;
+    } else {
+        log.seek(0);
+        QDataStream in(log.read(LOG_HEADER_SIZE));
+        in.setByteOrder(QDataStream::LittleEndian);
+        quint32 magic;
+        quint16 version;
+        in >> magic >> version;
+        if (magic != LOG_MAGIC || version != FORMAT_VERSION) {
+            qDebug() << "Unrecognised record log format:" << logPath;
+            log.close();
+            return false;
+        }
+    }
+
+    idx.setFileName(basePath + ".idx");
+    if (!idx.open(QIODevice::ReadWrite)) {
+        qDebug() << "Failed to open record index:" << idx.errorString();
+        return false;
+    }
+    if (!loadIndex()) {
+        // 索引缺失或与日志不一致（例如写入中途崩溃），从日志重建
+        scanLog();
+        writeIndex();
+    }
+
+    if (fresh && QFile::exists("records.txt")) {
+        migrateText("records.txt");
+    }
+    return true;
+}
+
+bool RecordStore::append(const Record& r) {
+    QByteArray payload;
+    QDataStream p(&payload, QIODevice::WriteOnly);
+    p.setByteOrder(QDataStream::LittleEndian);
+    p << qint32(r.time) << r.playerName.toUtf8() << r.difficulty.toUtf8() << r.dateTime.toUtf8();
+    if (payload.size() > 0xFFFF) return false;
+
+    QByteArray entry;
+    QDataStream e(&entry, QIODevice::WriteOnly);
+    e.setByteOrder(QDataStream::LittleEndian);
+    e << ENTRY_MARKER << nextSeq << qint32(r.score) << quint16(payload.size());
+    e << entryChecksum(entry, payload);
+    entry.append(payload);
+
+    quint64 offset = log.size();
+    log.seek(offset);
+    if (log.write(entry) != entry.size()) return false;
+    log.flush();
+    nextSeq++;
+
+    // 索引条目追加在末尾，再更新文件头中的日志长度；两步之间崩溃会在下次打开时重建
+    IndexEntry ie{offset, qint32(r.score), quint16(difficultyCode(r.difficulty)), 0};
+    QByteArray ib;
+    QDataStream i(&ib, QIODevice::WriteOnly);
+    i.setByteOrder(QDataStream::LittleEndian);
+    i << ie.offset << ie.score << ie.difficulty << ie.reserved;
+    idx.seek(idx.size());
+    idx.write(ib);
+    idx.seek(IDX_LOGSIZE_POS);
+    idx.write(encodeU64(log.size()));
+    idx.seek(IDX_NEXTSEQ_POS);
+    idx.write(encodeU32(nextSeq));
+    idx.flush();
+
+    // 内存中只追加到尾部，下次查询时再归并
+    tail.append(ie);
+    unsortedOnDisk++;
+    mergedValid = false;
+    sortedValid = false;
+    total++;
+    return true;
+}
+
+QVector<Record> RecordStore::top(int n, int difficultyCode) {
+    const QVector<IndexEntry>& list = scoreOrder(difficultyCode);
+    int limit = n < 0 ? list.size() : qMin(n, list.size());
+    QVector<Record> rs;
+    rs.reserve(limit);
+    for (int i = 0; i < limit; i++) {
+        Record r;
+        if (readEntry(list[i].offset, r)) rs.append(r);
+    }
+    return rs;
+}
+
+// 某难度（或所有难度归并后）按分数降序的索引，不读取日志
+const QVector<RecordStore::IndexEntry>& RecordStore::scoreOrder(int difficultyCode) {
+    static const QVector<IndexEntry> none;
+    ensureSorted();
+    if (difficultyCode >= 0) {
+        auto it = byDifficulty.constFind(difficultyCode);
+        return it == byDifficulty.constEnd() ? none : it.value();
+    }
+    if (!mergedValid) {
+        merged.clear();
+        merged.reserve(total);
+        QVector<const QVector<IndexEntry>*> lists;
+        QVector<int> pos;
+        for (auto it = byDifficulty.constBegin(); it != byDifficulty.constEnd(); ++it) {
+            lists.append(&it.value());
+            pos.append(0);
+        }
+        while (true) {
+            int best = -1;
+            for (int k = 0; k < lists.size(); k++) {
+                if (pos[k] >= lists[k]->size()) continue;
+                if (best < 0 || lists[k]->at(pos[k]).score > lists[best]->at(pos[best]).score) best = k;
+            }
+            if (best < 0) break;
+            merged.append(lists[best]->at(pos[best]++));
+        }
+        mergedValid = true;
+    }
+    return merged;
+}
+
+int RecordStore::queryCount(const RecordQuery& q) {
+    if (q.player.isEmpty()) {
+        return scoreOrder(q.difficulty.isEmpty() ? -1 : difficultyCode(q.difficulty)).size();
+    }
+    return sortedOffsets(q).size();
+}
+
+QVector<Record> RecordStore::query(const RecordQuery& q, int offset, int limit) {
+    QVector<Record> rs;
+    if (q.sortColumn == RecordQuery::Score && q.player.isEmpty()) {
+        // 直接在有序索引上取一页，升序时从末尾往前取
+        const QVector<IndexEntry>& list = scoreOrder(q.difficulty.isEmpty() ? -1 : difficultyCode(q.difficulty));
+        for (int i = offset; i < list.size() && rs.size() < limit; i++) {
+            int k = q.descending ? i : list.size() - 1 - i;
+            Record r;
+            if (readEntry(list[k].offset, r)) rs.append(r);
+        }
+        return rs;
+    }
+
+    const QVector<quint64>& offsets = sortedOffsets(q);
+    for (int i = offset; i < offsets.size() && rs.size() < limit; i++) {
+        Record r;
+        if (readEntry(offsets[i], r)) rs.append(r);
+    }
+    return rs;
+}
+
+// 其他排序没有索引：扫描一次日志排序，只缓存结果的偏移，翻页时按偏移读取
+const QVector<quint64>& RecordStore::sortedOffsets(const RecordQuery& q) {
+    if (sortedValid && sortedQuery == q) return sorted;
+
+    struct Item {
+        Record r;
+        quint64 offset;
+    };
+    QVector<Item> items;
+    const QVector<IndexEntry>& list = scoreOrder(q.difficulty.isEmpty() ? -1 : difficultyCode(q.difficulty));
+    for (const IndexEntry& e : list) {
+        Item item;
+        if (readEntry(e.offset, item.r) && matches(item.r, q)) {
+            item.offset = e.offset;
+            items.append(item);
+        }
+    }
+    std::stable_sort(items.begin(), items.end(), [&q](const Item& a, const Item& b) {
+        return q.descending ? lessThan(b.r, a.r, q.sortColumn) : lessThan(a.r, b.r, q.sortColumn);
+    });
+
+    sorted.clear();
+    sorted.reserve(items.size());
+    for (const Item& item : items) sorted.append(item.offset);
+    sortedQuery = q;
+    sortedValid = true;
+    return sorted;
+}
+
+QList<int> RecordStore::difficultyCodes() const {
+    const_cast<RecordStore*>(this)->ensureSorted();
+    return byDifficulty.keys();
+}
+
+QVector<qint32> RecordStore::scores(int difficultyCode) const {
+    const_cast<RecordStore*>(this)->ensureSorted();
+    QVector<qint32> rs;
+    const QVector<IndexEntry> list = byDifficulty.value(difficultyCode);
+    rs.reserve(list.size());
+    for (const IndexEntry& e : list) rs.append(e.score);
+    return rs;
+}
+
+int RecordStore::readFrom(quint64 offset, int max, QVector<Record>& out, QVector<quint32>& seqs, quint64& next) {
+    next = qMax<quint64>(offset, LOG_HEADER_SIZE);
+    quint64 end = log.size();
+    int n = 0;
+    while (next < end && n < max) {
+        Record r;
+        quint32 seq;
+        int size;
+        if (!readEntry(next, r, &seq, &size)) break;
+        out.append(r);
+        seqs.append(seq);
+        next += size;
+        n++;
+    }
+    return n;
+}
+
+bool RecordStore::readEntry(quint64 offset, Record& r, quint32 *seq, int *entrySize) {
+    if (!log.seek(offset)) return false;
+    QByteArray head = log.read(ENTRY_HEADER_SIZE);
+    if (head.size() != ENTRY_HEADER_SIZE) return false;
+
+    QDataStream h(head);
+    h.setByteOrder(QDataStream::LittleEndian);
+    quint32 marker, entrySeq;
+    qint32 score;
+    quint16 length, checksum;
+    h >> marker >> entrySeq >> score >> length >> checksum;
+    if (marker != ENTRY_MARKER) return false;
+
+    QByteArray payload = log.read(length);
+    if (payload.size() != length || entryChecksum(head, payload) != checksum) return false;
+
+    QDataStream p(payload);
+    p.setByteOrder(QDataStream::LittleEndian);
+    qint32 time;
+    QByteArray name, difficulty, dateTime;
+    p >> time >> name >> difficulty >> dateTime;
+    if (p.status() != QDataStream::Ok) return false;
+
+    r.score = score;
+    r.time = time;
+    r.playerName = QString::fromUtf8(name);
+    r.difficulty = QString::fromUtf8(difficulty);
+    r.dateTime = QString::fromUtf8(dateTime);
+    r.id = -1; // 本地记录没有ID
+    if (seq) *seq = entrySeq;
+    if (entrySize) *entrySize = ENTRY_HEADER_SIZE + length;
+    return true;
+}
+
+bool RecordStore::scanLog() {
+    byDifficulty.clear();
+    tail.clear();
+    sortedLoaded = true;
+    mergedValid = false;
+    sortedValid = false;
+    total = 0;
+    nextSeq = 0;
+
+    quint64 offset = LOG_HEADER_SIZE;
+    quint64 end = log.size();
+    while (offset < end) {
+        Record r;
+        quint32 seq;
+        int size;
+        if (!readEntry(offset, r, &seq, &size)) break;
+        tail.append({offset, qint32(r.score), quint16(difficultyCode(r.difficulty)), 0});
+        total++;
+        nextSeq = seq + 1;
+        offset += size;
+    }
+    if (offset < end) {
+        qDebug() << "Truncating damaged record log tail at" << offset;
+        log.resize(offset);
+    }
+    mergeTail();
+    return true;
+}
+
+// 只读文件头和有序部分之后追加的条目；有序部分留到第一次查询时由loadSorted读取
+bool RecordStore::loadIndex() {
+    if (idx.size() < IDX_HEADER_SIZE) return false;
+    idx.seek(0);
+    QDataStream head(idx.read(IDX_HEADER_SIZE));
+    head.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 magic, count, seq;
+    quint16 version, reserved;
+    quint64 logSize;
+    head >> magic >> version >> reserved >> logSize >> count >> seq;
+    const qint64 n = (idx.size() - IDX_HEADER_SIZE) / IDX_ENTRY_SIZE;
+    if (magic != IDX_MAGIC || version != FORMAT_VERSION || logSize != quint64(log.size()) || n < count) {
+        return false;
+    }
+
+    byDifficulty.clear();
+    tail.clear();
+    mergedValid = false;
+    sortedValid = false;
+    sortedLoaded = false;
+    sortedCount = count;
+    unsortedOnDisk = int(n - count);
+
+    idx.seek(IDX_HEADER_SIZE + qint64(count) * IDX_ENTRY_SIZE);
+    QDataStream in(idx.read(qint64(unsortedOnDisk) * IDX_ENTRY_SIZE));
+    in.setByteOrder(QDataStream::LittleEndian);
+    tail.reserve(unsortedOnDisk);
+    for (int i = 0; i < unsortedOnDisk; i++) {
+        IndexEntry e;
+        in >> e.offset >> e.score >> e.difficulty >> e.reserved;
+        tail.append(e);
+    }
+    if (in.status() != QDataStream::Ok) return false;
+    total = int(n);
+    nextSeq = seq;
+    return true;
+}
+
+bool RecordStore::loadSorted() {
+    idx.seek(IDX_HEADER_SIZE);
+    QByteArray data = idx.read(qint64(sortedCount) * IDX_ENTRY_SIZE);
+    if (data.size() != qint64(sortedCount) * IDX_ENTRY_SIZE) return false;
+    QDataStream in(data);
+    in.setByteOrder(QDataStream::LittleEndian);
+    for (quint32 i = 0; i < sortedCount; i++) {
+        IndexEntry e;
+        in >> e.offset >> e.score >> e.difficulty >> e.reserved;
+        byDifficulty[e.difficulty].append(e); // 有序部分按组写入，直接追加
+    }
+    sortedLoaded = true;
+    return true;
+}
+
+void RecordStore::ensureSorted() {
+    if (!sortedLoaded && !loadSorted()) {
+        qDebug() << "Record index damaged, rebuilding from log";
+        scanLog();
+        writeIndex();
+        return;
+    }
+    if (tail.isEmpty()) return;
+    mergeTail();
+    if (unsortedOnDisk >= INDEX_REWRITE_THRESHOLD) writeIndex();
+}
+
+// 把内存中的有序索引整体写回；调用前有序部分已读入且尾部已归并
+bool RecordStore::writeIndex() {
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << IDX_MAGIC << FORMAT_VERSION << quint16(0) << quint64(log.size())
+        << quint32(total) << nextSeq;
+
+    QList<int> codes = byDifficulty.keys();
+    std::sort(codes.begin(), codes.end());
+    for (int code : codes) {
+        for (const IndexEntry& e : byDifficulty[code]) {
+            out << e.offset << e.score << e.difficulty << e.reserved;
+        }
+    }
+
+    idx.resize(0);
+    idx.seek(0);
+    bool ok = idx.write(data) == data.size();
+    idx.flush();
+    sortedCount = quint32(total);
+    unsortedOnDisk = 0;
+    return ok;
+}
+
+// 尾部按分数稳定排序后与各组一次归并，O(n + k log k)；同分时旧记录在前
+void RecordStore::mergeTail() {
+    auto higher = [](const IndexEntry& a, const IndexEntry& b) { return a.score > b.score; };
+    std::stable_sort(tail.begin(), tail.end(), higher);
+    QHash<int, QVector<IndexEntry>> added;
+    for (const IndexEntry& e : tail) added[e.difficulty].append(e);
+    for (auto it = added.constBegin(); it != added.constEnd(); ++it) {
+        QVector<IndexEntry>& list = byDifficulty[it.key()];
+        QVector<IndexEntry> result(list.size() + it.value().size());
+        std::merge(list.constBegin(), list.constEnd(), it.value().constBegin(), it.value().constEnd(),
+                   result.begin(), higher);
+        list = result;
+    }
+    tail.clear();
+    mergedValid = false;
+    sortedValid = false;
+}
+
+// 导入旧版records.txt（空格分隔的文本行），导入后改名保留
+bool RecordStore::migrateText(const QString& path) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
+
+    int migrated = 0;
+    QTextStream in(&f);
+    while (!in.atEnd()) {
+        QString line = in.readLine();
+        QStringList parts = line.split(" ");
+        if (parts.size() >= 2) {
+            Record r;
+            r.score = parts[0].toInt();
+            r.time = parts[1].toInt();
+            r.playerName = parts.size() > 2 ? parts[2] : "Player";
+            // 旧版写入的是下拉框文字（如"⭐ Primary"），本身含空格：
+            // 末尾两段是日期和时间，玩家名与日期之间的全部内容都属于难度
+            if (parts.size() >= 6) {
+                r.difficulty = parts.mid(3, parts.size() - 5).join(" ");
+                r.dateTime = parts.mid(parts.size() - 2).join(" ");
+            } else {
+                r.difficulty = parts.size() > 3 ? parts[3] : "Primary";
+                r.dateTime = parts.size() > 4 ? parts.mid(4).join(" ") :
+                             QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss");
+            }
+            r.id = -1;
+            if (append(r)) migrated++;
+        }
+    }
+    f.close();
+
+    QFile::remove(path + ".bak");
+    QFile::rename(path, path + ".bak");
+    qDebug() << "Migrated" << migrated << "records from" << path;
+    return true;
+}
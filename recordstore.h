@@ -0,0 +1,71 @@
+#ifndef RECORDSTORE_H
+#define RECORDSTORE_H
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include "recordstorage.h"
+
+// 二进制追加式记录存储。
+// records.dat：文件头 + 若干条目，每条为16字节定长头（标记、序号、分数、长度、校验和）加变长负载，
+// 校验和覆盖头部的序号、分数、长度和负载；
+// records.idx：按难度分组、组内按分数降序的侧索引，新记录先追加在末尾。
+// 保存只追加两个文件的末尾，内存中的新条目先放在未排序的尾部，查询时才一次性归并；
+// 打开时只读索引头和追加的尾部，有序部分在第一次查询时读取。读取前N名只读N条记录。
+class RecordStore : public RecordStorage {
+public:
+    explicit RecordStore(const QString& basePath = "records");
+    ~RecordStore();
+
+    bool open() override; // 打开或恢复日志与索引，首次运行时迁移records.txt
+    QString name() const override { return basePath; }
+    bool append(const Record& r) override;
+    int count() const override { return total; }
+    QVector<Record> top(int n, int difficultyCode = -1) override; // n<0表示全部；difficultyCode<0表示所有难度
+    QList<int> difficultyCodes() const override;
+    QVector<qint32> scores(int difficultyCode) const override; // 只读索引，不读日志
+    // 按分数排序且不按玩家过滤时只读取所需的一页；其他列的排序需要扫描整个日志
+    int queryCount(const RecordQuery& q) override;
+    QVector<Record> query(const RecordQuery& q, int offset, int limit) override;
+    quint64 endOffset() const override { return quint64(log.size()); }
+    // 按写入顺序从offset起读取最多max条，next返回下一条的位置
+    int readFrom(quint64 offset, int max, QVector<Record>& out, QVector<quint32>& seqs, quint64& next) override;
+    quint32 nextSequence() const { return nextSeq; } // 下一条记录将使用的序号
+
+private:
+    struct IndexEntry {
+        quint64 offset;
+        qint32 score;
+        quint16 difficulty;
+        quint16 reserved;
+    };
+
+    QString basePath;
+    QFile log;
+    QFile idx;
+    QHash<int, QVector<IndexEntry>> byDifficulty; // 每组按分数降序
+    QVector<IndexEntry> tail;                     // 尚未归并进byDifficulty的新条目，按写入顺序
+    bool sortedLoaded;                            // 索引文件的有序部分已读入byDifficulty
+    quint32 sortedCount;                          // 索引文件中有序部分的条目数
+    int unsortedOnDisk;                           // 索引文件有序部分之后追加的条目数
+    QVector<IndexEntry> merged;                   // 所有难度合并后的有序索引，按需生成
+    bool mergedValid;
+    RecordQuery sortedQuery;                      // 最近一次非索引排序的条件
+    QVector<quint64> sorted;                      // 及其结果的日志偏移
+    bool sortedValid;
+    int total;
+    quint32 nextSeq;
+
+    bool readEntry(quint64 offset, Record& r, quint32 *seq = nullptr, int *entrySize = nullptr);
+    bool scanLog();           // 顺序扫描日志重建索引，截掉末尾损坏的条目
+    bool loadIndex();
+    bool writeIndex();        // 把内存中的有序索引整体写回
+    bool loadSorted();        // 读取索引文件的有序部分
+    void mergeTail();         // 把tail归并进各难度的有序列表
+    void ensureSorted();      // 查询前调用：按需读取有序部分并归并尾部
+    const QVector<IndexEntry>& scoreOrder(int difficultyCode);
+    const QVector<quint64>& sortedOffsets(const RecordQuery& q);
+    bool migrateText(const QString& path);
+};
+
+#endif
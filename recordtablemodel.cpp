@@ -0,0 +1,136 @@
+#include "recordtablemodel.h"
+#include <algorithm>
+
+RecordTableModel::RecordTableModel(QObject *parent)
+    : QAbstractTableModel(parent), total(0), cloudPos(0), localPos(0), localOffset(0), localTotal(0)
+{
+}
+
+void RecordTableModel::setFilter(const QString& difficulty, const QString& player) {
+    query.difficulty = difficulty;
+    query.player = player;
+    refresh();
+}
+
+void RecordTableModel::setCloudRecords(const QVector<Record>& records) {
+    cloud.clear();
+    cloudKeys.clear();
+    QSet<int> ids;
+    for (const Record& r : records) {
+        if (ids.contains(r.id)) continue;
+        ids.insert(r.id);
+        cloud.append(r);
+        cloudKeys.insert(contentKey(r));
+    }
+}
+
+void RecordTableModel::refresh() {
+    // 只取总数，行数据等视图需要时再读
+    beginResetModel();
+    rows.clear();
+    localPage.clear();
+    localPos = 0;
+    localOffset = 0;
+    localTotal = RecordManager::queryCount(query);
+
+    cloudView.clear();
+    for (const Record& r : cloud) {
+        if (RecordStorage::matches(r, query)) cloudView.append(r);
+    }
+    std::stable_sort(cloudView.begin(), cloudView.end(), [this](const Record& a, const Record& b) {
+        return before(a, b);
+    });
+    cloudPos = 0;
+    total = localTotal + cloudView.size(); // 归并时遇到重复的本地记录再减去
+    endResetModel();
+}
+
+bool RecordTableModel::before(const Record& a, const Record& b) const {
+    return query.descending ? RecordStorage::lessThan(b, a, query.sortColumn)
+                            : RecordStorage::lessThan(a, b, query.sortColumn);
+}
+
+// 本地记录没有云端id，按内容识别同一局
+QString RecordTableModel::contentKey(const Record& r) {
+    return QString("%1|%2|%3|%4").arg(r.playerName).arg(r.score).arg(r.time).arg(r.dateTime);
+}
+
+int RecordTableModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : rows.size();
+}
+
+int RecordTableModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : 5;
+}
+
+QVariant RecordTableModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= rows.size()) return QVariant();
+    if (role == Qt::TextAlignmentRole && index.column() < 2) {
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    }
+    if (role != Qt::DisplayRole) return QVariant();
+
+    const Record& r = rows[index.row()];
+    switch (index.column()) {
+        case 0: return r.score;
+        case 1: return r.time;
+        case 2: return r.playerName;
+        case 3: return r.difficulty;
+        case 4: return r.dateTime;
+    }
+    return QVariant();
+}
+
+QVariant RecordTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role != Qt::DisplayRole) return QVariant();
+    if (orientation == Qt::Vertical) return section + 1; // 名次
+    static const char* titles[] = {"Score", "Time Left", "Player", "Difficulty", "Date/Time"};
+    return section >= 0 && section < 5 ? QVariant(titles[section]) : QVariant();
+}
+
+bool RecordTableModel::canFetchMore(const QModelIndex& parent) const {
+    if (parent.isValid()) return false;
+    return localPos < localPage.size() || localOffset < localTotal || cloudPos < cloudView.size();
+}
+
+void RecordTableModel::fetchMore(const QModelIndex& parent) {
+    if (parent.isValid()) return;
+    QVector<Record> page;
+    while (page.size() < PAGE_SIZE) {
+        if (localPos >= localPage.size() && localOffset < localTotal) {
+            localPage = RecordManager::queryRecords(query, localOffset, PAGE_SIZE);
+            localPos = 0;
+            if (localPage.isEmpty()) {
+                // 存储在此期间变短（例如日志尾部被截断）
+                total -= localTotal - localOffset;
+                localTotal = localOffset;
+            }
+            localOffset += localPage.size();
+        }
+        bool hasLocal = localPos < localPage.size();
+        bool hasCloud = cloudPos < cloudView.size();
+        if (!hasLocal && !hasCloud) break;
+
+        if (hasCloud && (!hasLocal || before(cloudView[cloudPos], localPage[localPos]))) {
+            page.append(cloudView[cloudPos++]);
+            continue;
+        }
+        const Record& r = localPage[localPos++];
+        if (!cloudKeys.isEmpty() && cloudKeys.contains(contentKey(r))) {
+            total--; // 已经上传，云端那条会显示
+            continue;
+        }
+        page.append(r);
+    }
+    if (page.isEmpty()) return;
+    beginInsertRows(QModelIndex(), rows.size(), rows.size() + page.size() - 1);
+    rows += page;
+    endInsertRows();
+}
+
+void RecordTableModel::sort(int column, Qt::SortOrder order) {
+    if (column < 0 || column >= 5) return;
+    query.sortColumn = RecordQuery::Column(column);
+    query.descending = order == Qt::DescendingOrder;
+    refresh();
+}
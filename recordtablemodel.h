@@ -0,0 +1,50 @@
+#ifndef RECORDTABLEMODEL_H
+#define RECORDTABLEMODEL_H
+#include <QAbstractTableModel>
+#include <QVector>
+#include <QSet>
+#include "recordmanager.h"
+#include "recordstorage.h"
+
+// 直接由记录存储支撑的表格模型：只保存已经滚动到的行，
+// 视图滚到底部时通过fetchMore按页读取，排序和过滤都交给存储后端。
+// 设置了云端记录时，与本地记录按同一顺序归并显示，已上传的本地记录不重复出现。
+class RecordTableModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    explicit RecordTableModel(QObject *parent = nullptr);
+
+    void setFilter(const QString& difficulty, const QString& player); // 重新从第一页开始
+    void refresh();
+    void setCloudRecords(const QVector<Record>& records); // 下次refresh时生效
+    int totalCount() const { return total; }
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    static const int PAGE_SIZE = 200;
+
+private:
+    RecordQuery query;
+    QVector<Record> rows; // 已读取的前若干行
+    int total;            // 满足过滤条件的总行数
+
+    QVector<Record> cloud;       // 全部云端记录（已按id去重）
+    QSet<QString> cloudKeys;     // 云端记录的内容键，用于识别已上传的本地记录
+    QVector<Record> cloudView;   // 过滤、排序后的云端记录
+    int cloudPos;
+    QVector<Record> localPage;   // 本地记录当前页，与cloudView归并
+    int localPos;
+    int localOffset;             // 下一页本地记录的起点
+    int localTotal;
+
+    bool before(const Record& a, const Record& b) const;
+    static QString contentKey(const Record& r);
+};
+
+#endif
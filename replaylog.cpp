@@ -0,0 +1,224 @@
+#include "replaylog.h"
+#include "varint.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+const char REPLAY_MAGIC[4] = {'L', 'L', 'K', 'P'};
+const quint8 REPLAY_VERSION = 2; // 版本2在头部增加图案种类数
+}
+
+void ReplayRecorder::begin(const ReplayHeader& header) {
+    data.clear();
+    data.append(REPLAY_MAGIC, 4);
+    data.append(char(REPLAY_VERSION));
+    putVarint(data, header.seed);
+    putVarint(data, header.rows);
+    putVarint(data, header.cols);
+    putVarint(data, header.difficulty);
+    putVarint(data, header.shiftRule);
+    putVarint(data, header.typeCount);
+    cols = header.cols;
+    lastMs = 0;
+    clock.start();
+    active = true;
+}
+
+void ReplayRecorder::appendEvent(ReplayEvent::Type type) {
+    if (!active) return;
+    qint64 now = clock.elapsed();
+    putVarint(data, (quint64(now - lastMs) << 2) | type);
+    lastMs = now;
+}
+
+void ReplayRecorder::recordMatch(const QPoint& a, const QPoint& b) {
+    if (!active) return;
+    appendEvent(ReplayEvent::Match);
+    putVarint(data, quint64(a.x() * cols + a.y()));
+    putVarint(data, quint64(b.x() * cols + b.y()));
+}
+
+QByteArray ReplayRecorder::finish() {
+    if (!active) return QByteArray();
+    appendEvent(ReplayEvent::End);
+    active = false;
+    return data;
+}
+
+bool ReplayRecorder::save(const QString& path) {
+    QByteArray log = finish();
+    if (log.isEmpty()) return false;
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    f.write(log);
+    return f.commit();
+}
+
+bool decodeReplay(const QByteArray& data, ReplayHeader& header, QVector<ReplayEvent>& events) {
+    if (data.size() < 5 || memcmp(data.constData(), REPLAY_MAGIC, 4) != 0) return false;
+    const quint8 version = quint8(data[4]);
+    if (version < 1 || version > REPLAY_VERSION) return false;
+    int pos = 5;
+    quint64 seed, rows, cols, difficulty, shift, typeCount;
+    if (!getVarint(data, pos, seed) || !getVarint(data, pos, rows) || !getVarint(data, pos, cols)
+        || !getVarint(data, pos, difficulty) || !getVarint(data, pos, shift)) {
+        return false;
+    }
+    if (rows == 0 || cols == 0 || rows * cols > 1000000 || difficulty > ADVANCED || shift > SHIFT_CENTER) {
+        return false;
+    }
+    if (version >= 2) {
+        if (!getVarint(data, pos, typeCount) || typeCount == 0 || typeCount > quint64(BoardEngine::MAX_TILE_TYPES)) {
+            return false;
+        }
+    } else {
+        typeCount = qMin<quint64>(rows * cols / 2, 8);
+    }
+    header.seed = seed;
+    header.rows = int(rows);
+    header.cols = int(cols);
+    header.difficulty = Difficulty(difficulty);
+    header.shiftRule = ShiftRule(shift);
+    header.typeCount = int(typeCount);
+
+    events.clear();
+    quint32 timeMs = 0;
+    while (pos < data.size()) {
+        quint64 head;
+        if (!getVarint(data, pos, head)) return false;
+        ReplayEvent e;
+        e.type = ReplayEvent::Type(head & 3);
+        timeMs += quint32(head >> 2);
+        e.timeMs = timeMs;
+        if (e.type == ReplayEvent::Match) {
+            quint64 ca, cb;
+            if (!getVarint(data, pos, ca) || !getVarint(data, pos, cb)) return false;
+            if (ca >= rows * cols || cb >= rows * cols) return false;
+            e.a = QPoint(int(ca / cols), int(ca % cols));
+            e.b = QPoint(int(cb / cols), int(cb % cols));
+        }
+        events.append(e);
+        if (e.type == ReplayEvent::End) break;
+    }
+    return true;
+}
+
+ReplayPlayer::ReplayPlayer(QObject *parent)
+    : QObject(parent), pos(0), score(0), pairsRemoved(0), speed(1.0)
+{
+    timer = new QTimer(this);
+    timer->setSingleShot(true);
+    connect(timer, &QTimer::timeout, this, &ReplayPlayer::onTimer);
+}
+
+bool ReplayPlayer::loadFile(const QString& path) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    return load(f.readAll());
+}
+
+bool ReplayPlayer::load(const QByteArray& data) {
+    pause();
+    if (!decodeReplay(data, header, events)) return false;
+    checkpoints.clear();
+    restart();
+    return true;
+}
+
+// 用种子重新生成开局布局
+void ReplayPlayer::restart() {
+    rng.reseed(header.seed);
+    engine.setMap(BoardEngine::generateLayout(header.rows, header.cols, header.difficulty, rng,
+                                              nullptr, header.typeCount));
+    engine.setShiftRule(header.shiftRule);
+    pos = 0;
+    score = 0;
+    pairsRemoved = 0;
+    if (checkpoints.isEmpty()) {
+        checkpoints.append({engine, rng.state(), score, pairsRemoved});
+    }
+    emit positionChanged(pos);
+}
+
+void ReplayPlayer::apply(const ReplayEvent& e) {
+    switch (e.type) {
+        case ReplayEvent::Match:
+            if (engine.at(e.a) == 0 || engine.at(e.a) != engine.at(e.b) || !engine.canLink(e.a, e.b, 2)) {
+                qDebug() << "Replay diverged at event" << pos << e.a << e.b;
+                emit diverged(pos);
+                break;
+            }
+            engine.removePair(e.a, e.b);
+            pairsRemoved++;
+            score += BoardEngine::pointsFor(header.difficulty);
+            break;
+        case ReplayEvent::Reshuffle: {
+            // 与界面一致：仍有可消除的对时重排扣分
+            QPoint ha, hb;
+            if (engine.findHint(ha, hb)) score -= qMin(score, 50);
+            engine.shuffleRemaining(rng);
+            pairsRemoved = 0;
+            break;
+        }
+        case ReplayEvent::Hint:
+        case ReplayEvent::End:
+            break;
+    }
+}
+
+bool ReplayPlayer::step() {
+    if (pos >= events.size()) return false;
+    const ReplayEvent& e = events[pos];
+    apply(e);
+    pos++;
+    // 第一次经过时顺便保存检查点
+    if (pos % CHECKPOINT_INTERVAL == 0 && checkpoints.size() == pos / CHECKPOINT_INTERVAL) {
+        checkpoints.append({engine, rng.state(), score, pairsRemoved});
+    }
+    emit eventApplied(pos - 1, e);
+    emit positionChanged(pos);
+    return true;
+}
+
+void ReplayPlayer::seek(int index) {
+    index = qBound(0, index, events.size());
+    // 向前跳时若当前位置比检查点更近，直接从当前位置继续
+    int k = qMin(index / CHECKPOINT_INTERVAL, checkpoints.size() - 1);
+    if (index < pos || k * CHECKPOINT_INTERVAL > pos) {
+        const Checkpoint& c = checkpoints[k];
+        engine = c.engine;
+        rng.setState(c.rng);
+        score = c.score;
+        pairsRemoved = c.pairsRemoved;
+        pos = k * CHECKPOINT_INTERVAL;
+    }
+    bool wasBlocked = blockSignals(true); // 中间步骤不逐个通知
+    while (pos < index) step();
+    blockSignals(wasBlocked);
+    emit positionChanged(pos);
+}
+
+void ReplayPlayer::play(qreal playSpeed) {
+    speed = playSpeed > 0 ? playSpeed : 1.0;
+    scheduleNext();
+}
+
+void ReplayPlayer::pause() {
+    timer->stop();
+}
+
+void ReplayPlayer::scheduleNext() {
+    if (pos >= events.size()) {
+        emit finished();
+        return;
+    }
+    quint32 prev = pos > 0 ? events[pos - 1].timeMs : 0;
+    timer->start(int((events[pos].timeMs - prev) / speed));
+}
+
+void ReplayPlayer::onTimer() {
+    step();
+    scheduleNext();
+}
@@ -0,0 +1,112 @@
+#ifndef REPLAYLOG_H
+#define REPLAYLOG_H
+#include <QObject>
+#include <QByteArray>
+#include <QVector>
+#include <QPoint>
+#include <QElapsedTimer>
+#include <QTimer>
+#include "boardengine.h"
+
+// 一局的回放：种子和棋盘参数决定初始布局与之后每次重排，
+// 其后是按时间顺序的操作（消除的一对格子、重排、提示）。
+struct ReplayEvent {
+    enum Type { Match = 0, Reshuffle = 1, Hint = 2, End = 3 };
+    Type type;
+    quint32 timeMs; // 相对开局的毫秒数
+    QPoint a;       // 仅Match
+    QPoint b;
+};
+
+struct ReplayHeader {
+    quint64 seed = 0;
+    int rows = 0;
+    int cols = 0;
+    Difficulty difficulty = PRIMARY;
+    ShiftRule shiftRule = SHIFT_NONE;
+    int typeCount = 0; // 生成布局时的图案种类数；版本1的回放没有此项，按当时固定最多8种
+};
+
+// 录制：每个事件一个变长整数头（时间增量<<2 | 类型），消除事件再加两个格子编号，
+// 通常每步只占3~4个字节。
+class ReplayRecorder {
+public:
+    ReplayRecorder() : active(false) {}
+    void begin(const ReplayHeader& header);
+    void stop() { active = false; } // 例如从存档恢复，之前的操作已不可知
+    bool isActive() const { return active; }
+    void recordMatch(const QPoint& a, const QPoint& b);
+    void recordReshuffle() { appendEvent(ReplayEvent::Reshuffle); }
+    void recordHint() { appendEvent(ReplayEvent::Hint); }
+    QByteArray finish(); // 追加End事件并返回完整日志
+    bool save(const QString& path);
+
+private:
+    bool active;
+    int cols;
+    QByteArray data;
+    QElapsedTimer clock;
+    qint64 lastMs;
+
+    void appendEvent(ReplayEvent::Type type);
+};
+
+// 解码回放日志
+bool decodeReplay(const QByteArray& data, ReplayHeader& header, QVector<ReplayEvent>& events);
+
+// 回放播放器：不依赖界面，在BoardEngine上按原顺序重新执行操作。
+// 支持按倍速播放；跳转时从最近的检查点（每CHECKPOINT_INTERVAL个事件一个）恢复再向前重放。
+class ReplayPlayer : public QObject {
+    Q_OBJECT
+public:
+    explicit ReplayPlayer(QObject *parent = nullptr);
+
+    bool load(const QByteArray& data);
+    bool loadFile(const QString& path);
+    const ReplayHeader& getHeader() const { return header; }
+    int eventCount() const { return events.size(); }
+    int position() const { return pos; } // 已执行的事件数
+    const BoardEngine& board() const { return engine; }
+    int getScore() const { return score; }
+
+    bool step();          // 执行下一个事件
+    void seek(int index); // 跳到执行完前index个事件的状态
+    void play(qreal speed = 1.0); // speed>1为快进
+    void pause();
+
+    static const int CHECKPOINT_INTERVAL = 64;
+
+signals:
+    void eventApplied(int index, const ReplayEvent& event);
+    void diverged(int index); // 记录的操作在当前棋盘上不合法，通常说明规则或生成逻辑变了
+    void positionChanged(int position);
+    void finished();
+
+private slots:
+    void onTimer();
+
+private:
+    struct Checkpoint {
+        BoardEngine engine; // 地图与索引隐式共享，之后修改时才复制
+        GameRng::State rng;
+        int score;
+        int pairsRemoved;
+    };
+
+    ReplayHeader header;
+    QVector<ReplayEvent> events;
+    QVector<Checkpoint> checkpoints; // checkpoints[k]对应执行完k*CHECKPOINT_INTERVAL个事件
+    BoardEngine engine;
+    GameRng rng;
+    int pos;
+    int score;
+    int pairsRemoved;
+    QTimer *timer;
+    qreal speed;
+
+    void restart();
+    void apply(const ReplayEvent& e);
+    void scheduleNext();
+};
+
+#endif
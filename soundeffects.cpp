@@ -0,0 +1,123 @@
+#include "soundeffects.h"
+#include <QMediaDevices>
+#include <QAudioDevice>
+#include <QAudioBuffer>
+#include <QUrl>
+#include <QDebug>
+#include <cstring>
+
+PcmMixer::PcmMixer(const QAudioFormat& format, QObject *parent)
+    : QIODevice(parent), format(format)
+{
+}
+
+void PcmMixer::play(const QByteArray& pcm, qreal volume) {
+    QMutexLocker locker(&mutex);
+    Voice v{pcm, 0, qBound(0, int(volume * 256), 1024)};
+    if (voices.size() >= MAX_VOICES) {
+        voices.removeFirst();
+    }
+    voices.append(v);
+}
+
+void PcmMixer::stopAll() {
+    QMutexLocker locker(&mutex);
+    voices.clear();
+}
+
+qint64 PcmMixer::readData(char *data, qint64 maxlen) {
+    int samples = int(maxlen / sizeof(qint16));
+    qint16 *out = reinterpret_cast<qint16*>(data);
+
+    QMutexLocker locker(&mutex);
+    if (voices.isEmpty()) {
+        memset(data, 0, samples * sizeof(qint16));
+        return samples * sizeof(qint16);
+    }
+
+    accum.fill(0, samples);
+    for (int k = voices.size() - 1; k >= 0; k--) {
+        Voice& v = voices[k];
+        const qint16 *src = reinterpret_cast<const qint16*>(v.pcm.constData());
+        int total = v.pcm.size() / int(sizeof(qint16));
+        int n = qMin(samples, total - v.pos);
+        for (int i = 0; i < n; i++) {
+            accum[i] += (src[v.pos + i] * v.gain) >> 8;
+        }
+        v.pos += n;
+        if (v.pos >= total) voices.removeAt(k);
+    }
+    for (int i = 0; i < samples; i++) {
+        out[i] = qint16(qBound(-32768, accum[i], 32767));
+    }
+    return samples * sizeof(qint16);
+}
+
+qint64 PcmMixer::writeData(const char *, qint64) {
+    return -1;
+}
+
+qint64 PcmMixer::bytesAvailable() const {
+    // 始终可读：没有声部时输出静音
+    return format.bytesForDuration(100000) + QIODevice::bytesAvailable();
+}
+
+SoundEffects::SoundEffects(QObject *parent) : QObject(parent) {
+    // 统一解码为输出设备的采样率与声道数、16位整数样本，混音时不再转换
+    QAudioDevice device = QMediaDevices::defaultAudioOutput();
+    format = device.preferredFormat();
+    format.setSampleFormat(QAudioFormat::Int16);
+    if (!device.isFormatSupported(format)) {
+        format.setSampleRate(44100);
+        format.setChannelCount(2);
+    }
+
+    mixer = new PcmMixer(format, this);
+    mixer->open(QIODevice::ReadOnly);
+    sink = new QAudioSink(device, format, this);
+    // 小缓冲：约10毫秒，触发到出声的延迟主要由它决定
+    sink->setBufferSize(format.bytesForDuration(10000) * 2);
+    sink->start(mixer);
+}
+
+SoundEffects::~SoundEffects() {
+    sink->stop();
+}
+
+void SoundEffects::load(int id, const QString& path) {
+    QAudioDecoder *decoder = new QAudioDecoder(this);
+    decoder->setAudioFormat(format);
+    decoder->setSource(QUrl::fromLocalFile(path));
+    decoding.insert(id, QByteArray());
+
+    connect(decoder, &QAudioDecoder::bufferReady, this, [this, decoder, id]() {
+        QAudioBuffer buffer = decoder->read();
+        decoding[id].append(buffer.constData<char>(), buffer.byteCount());
+    });
+    connect(decoder, &QAudioDecoder::finished, this, [this, decoder, id, path]() {
+        buffers.insert(id, decoding.take(id));
+        qDebug() << "Decoded sound" << path << buffers.value(id).size() << "bytes";
+        if (pendingPlays.contains(id)) {
+            play(id, pendingPlays.take(id));
+        }
+        decoder->deleteLater();
+    });
+    connect(decoder, QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error), this,
+            [this, decoder, id, path](QAudioDecoder::Error) {
+        qDebug() << "Failed to decode sound" << path << decoder->errorString();
+        decoding.remove(id);
+        pendingPlays.remove(id);
+        decoder->deleteLater();
+    });
+    decoder->start();
+}
+
+void SoundEffects::play(int id, qreal volume) {
+    auto it = buffers.constFind(id);
+    if (it == buffers.constEnd()) {
+        if (decoding.contains(id)) pendingPlays.insert(id, volume);
+        return;
+    }
+    if (it->isEmpty()) return;
+    mixer->play(it.value(), volume);
+}
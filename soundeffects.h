@@ -0,0 +1,63 @@
+#ifndef SOUNDEFFECTS_H
+#define SOUNDEFFECTS_H
+#include <QObject>
+#include <QIODevice>
+#include <QAudioFormat>
+#include <QAudioSink>
+#include <QAudioDecoder>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+// 把若干路预先解码好的PCM叠加输出的混音器，由QAudioSink以拉取模式读取。
+// 没有声音时输出静音，输出设备一直保持打开，触发音效只需加入一路声部。
+class PcmMixer : public QIODevice {
+    Q_OBJECT
+public:
+    explicit PcmMixer(const QAudioFormat& format, QObject *parent = nullptr);
+    void play(const QByteArray& pcm, qreal volume); // pcm为与format一致的16位交错样本
+    void stopAll();
+
+    static const int MAX_VOICES = 8; // 超出时替换最早开始的一路
+
+protected:
+    qint64 readData(char *data, qint64 maxlen) override;
+    qint64 writeData(const char *data, qint64 len) override;
+    qint64 bytesAvailable() const override;
+    bool isSequential() const override { return true; }
+
+private:
+    struct Voice {
+        QByteArray pcm; // 隐式共享，不复制样本
+        int pos;        // 下一个样本的下标
+        int gain;       // 音量，定点数，256为原始音量
+    };
+    QAudioFormat format;
+    QVector<Voice> voices;
+    QVector<qint32> accum;
+    QMutex mutex; // 音频后端可能在自己的线程上调用readData
+};
+
+// 短音效：启动时把音频文件解码为PCM缓存在内存中，播放走低延迟的混音输出，
+// 多个音效可以同时发声，互不打断。
+class SoundEffects : public QObject {
+    Q_OBJECT
+public:
+    explicit SoundEffects(QObject *parent = nullptr);
+    ~SoundEffects();
+
+    void load(int id, const QString& path); // 异步解码，完成前的播放请求在解码完成后执行
+    bool isLoaded(int id) const { return buffers.contains(id); }
+    void play(int id, qreal volume = 1.0);
+
+private:
+    QAudioFormat format;
+    QAudioSink *sink;
+    PcmMixer *mixer;
+    QHash<int, QByteArray> buffers;  // 解码完成的音效
+    QHash<int, QByteArray> decoding; // 正在解码的音效已得到的部分
+    QHash<int, qreal> pendingPlays;  // 解码完成前请求播放的音效，每种只保留一次
+};
+
+#endif
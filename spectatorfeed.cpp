@@ -0,0 +1,151 @@
+#include "spectatorfeed.h"
+#include "varint.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QtEndian>
+#include <QDebug>
+
+SpectatorFeed::SpectatorFeed(QObject* parent)
+    : QObject(parent), seq(0), cols(0), server(nullptr)
+{
+}
+
+bool SpectatorFeed::listen(const QString& name) {
+    if (!server) {
+        server = new QLocalServer(this);
+        connect(server, &QLocalServer::newConnection, this, &SpectatorFeed::onNewConnection);
+    }
+    QLocalServer::removeServer(name); // 清理上次异常退出留下的套接字文件
+    if (!server->listen(name)) {
+        qDebug() << "Spectator feed cannot listen on" << name << server->errorString();
+        return false;
+    }
+    return true;
+}
+
+void SpectatorFeed::onNewConnection() {
+    while (QLocalSocket* socket = server->nextPendingConnection()) {
+        sockets.append(socket);
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+            sockets.removeOne(socket);
+            socket->deleteLater();
+        });
+        for (const QByteArray& frame : backlog) writeFrame(socket, frame);
+    }
+}
+
+QByteArray SpectatorFeed::beginFrame(FrameType type) {
+    QByteArray frame;
+    frame.append(char(type));
+    putVarint(frame, ++seq);
+    return frame;
+}
+
+void SpectatorFeed::publishSnapshot(const BoardEngine& engine) {
+    cols = engine.colCount();
+    QByteArray frame = beginFrame(Snapshot);
+    putVarint(frame, engine.rowCount());
+    putVarint(frame, cols);
+    putVarint(frame, engine.getShiftRule());
+    putVarint(frame, engine.tileWidth());
+    frame += qCompress(BoardEngine::tilesLittleEndian(engine.packedTiles(), engine.tileWidth()), 9);
+    // 快照之前的增量不再需要
+    backlog.clear();
+    publish(frame);
+}
+
+void SpectatorFeed::publishMatch(const QPoint& a, const QPoint& b) {
+    QByteArray frame = beginFrame(Match);
+    putVarint(frame, quint64(a.x() * cols + a.y()));
+    putVarint(frame, quint64(b.x() * cols + b.y()));
+    publish(frame);
+}
+
+void SpectatorFeed::publishReshuffle(const QVector<int>& permutation) {
+    QByteArray frame = beginFrame(Reshuffle);
+    putVarint(frame, permutation.size());
+    for (int k : permutation) putVarint(frame, k);
+    publish(frame);
+}
+
+void SpectatorFeed::publish(const QByteArray& frame) {
+    backlog.append(frame);
+    emit frameReady(frame);
+    const QList<QLocalSocket*> targets = sockets; // 断开慢订阅者会修改sockets
+    for (QLocalSocket* socket : targets) writeFrame(socket, frame);
+}
+
+void SpectatorFeed::writeFrame(QLocalSocket* socket, const QByteArray& frame) {
+    if (socket->bytesToWrite() > MAX_PENDING_BYTES) {
+        qDebug() << "Dropping slow spectator";
+        socket->abort();
+        return;
+    }
+    quint32 len = qToLittleEndian(quint32(frame.size()));
+    socket->write(reinterpret_cast<const char*>(&len), sizeof(len));
+    socket->write(frame);
+}
+
+bool SpectatorBoard::apply(const QByteArray& frame) {
+    if (frame.isEmpty()) return false;
+    int pos = 1;
+    quint64 frameSeq;
+    if (!getVarint(frame, pos, frameSeq)) return false;
+    int type = quint8(frame[0]);
+
+    if (type == SpectatorFeed::Snapshot) {
+        quint64 rows, cols, shift, width;
+        if (!getVarint(frame, pos, rows) || !getVarint(frame, pos, cols) || !getVarint(frame, pos, shift)
+            || !getVarint(frame, pos, width) || shift > SHIFT_CENTER || (width != 1 && width != 2)) {
+            return false;
+        }
+        QByteArray tiles = qUncompress(frame.mid(pos));
+        if (quint64(tiles.size()) != rows * cols * width) return false;
+        if (!engine.setPacked(int(rows), int(cols), BoardEngine::tilesLittleEndian(tiles, int(width)), int(width))) {
+            return false;
+        }
+        engine.setShiftRule(ShiftRule(shift));
+        seq = quint32(frameSeq);
+        synced = true;
+        return true;
+    }
+
+    // 增量必须紧接上一帧
+    if (!synced || frameSeq != quint64(seq) + 1) {
+        synced = false;
+        return false;
+    }
+    const quint64 cellCount = quint64(engine.rowCount()) * engine.colCount();
+    if (type == SpectatorFeed::Match) {
+        quint64 ia, ib;
+        if (!getVarint(frame, pos, ia) || !getVarint(frame, pos, ib) || ia >= cellCount || ib >= cellCount) {
+            return false;
+        }
+        const int cols = engine.colCount();
+        engine.removePair(QPoint(int(ia) / cols, int(ia) % cols), QPoint(int(ib) / cols, int(ib) % cols));
+    } else if (type == SpectatorFeed::Reshuffle) {
+        QVector<QPoint> positions;
+        QVector<int> values;
+        for (int i = 0; i < engine.rowCount(); i++) {
+            for (int j = 0; j < engine.colCount(); j++) {
+                if (engine.at(i, j) != 0) {
+                    positions.append(QPoint(i, j));
+                    values.append(engine.at(i, j));
+                }
+            }
+        }
+        quint64 n;
+        if (!getVarint(frame, pos, n) || n != quint64(positions.size())) return false;
+        QVector<int> permutation(positions.size());
+        for (int& k : permutation) {
+            quint64 v;
+            if (!getVarint(frame, pos, v) || v >= n) return false;
+            k = int(v);
+        }
+        for (int k = 0; k < positions.size(); k++) engine.setCell(positions[k], values[permutation[k]]);
+    } else {
+        return false;
+    }
+    seq = quint32(frameSeq);
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef SPECTATORFEED_H
+#define SPECTATORFEED_H
+#include <QObject>
+#include <QByteArray>
+#include <QVector>
+#include <QList>
+#include <QPoint>
+#include "boardengine.h"
+
+class QLocalServer;
+class QLocalSocket;
+
+// 观战数据流：新局（或从存档恢复）时发一个压缩的整盘快照，之后每步只发增量。
+// 帧格式：类型(1字节) + 序号(变长整数) + 内容
+//   快照：行、列、移动规则、每格字节数，之后是qCompress压缩的图案（每格1或2字节，小端）
+//   消除：两个格子编号（观战端按同一移动规则自行移动图块）
+//   重排：剩余格子数和置换，置换下标按行优先的非空格子编号
+// 每帧只编码一次；QByteArray隐式共享，进程内订阅者和积压列表拿到的都是同一块只读内存。
+class SpectatorFeed : public QObject {
+    Q_OBJECT
+public:
+    // 类型0是旧版不带图案宽度的快照，已停用；旧观战端收到新快照会拒绝而不是解析出错误图案
+    enum FrameType { Match = 1, Reshuffle = 2, Snapshot = 3 };
+
+    explicit SpectatorFeed(QObject* parent = nullptr);
+
+    bool listen(const QString& name); // 供其他进程订阅的本地套接字，每帧前加4字节长度
+    void publishSnapshot(const BoardEngine& engine);
+    void publishMatch(const QPoint& a, const QPoint& b);
+    void publishReshuffle(const QVector<int>& permutation);
+
+    // 中途加入的订阅者先依次处理这些帧，再接收frameReady
+    QVector<QByteArray> catchUp() const { return backlog; }
+
+    static const qint64 MAX_PENDING_BYTES = 1 << 20; // 跟不上的套接字订阅者直接断开
+
+signals:
+    void frameReady(const QByteArray& frame);
+
+private slots:
+    void onNewConnection();
+
+private:
+    quint32 seq;
+    int cols;
+    QVector<QByteArray> backlog; // 最近的快照及其后的增量
+    QLocalServer* server;
+    QList<QLocalSocket*> sockets;
+
+    QByteArray beginFrame(FrameType type);
+    void publish(const QByteArray& frame);
+    void writeFrame(QLocalSocket* socket, const QByteArray& frame);
+};
+
+// 观战端：按顺序应用帧，还原出棋盘
+class SpectatorBoard {
+public:
+    // 序号不连续或内容无法解析时返回false，需要等待下一个快照
+    bool apply(const QByteArray& frame);
+    bool isSynced() const { return synced; }
+    const BoardEngine& board() const { return engine; }
+    quint32 sequence() const { return seq; }
+
+private:
+    BoardEngine engine;
+    quint32 seq = 0;
+    bool synced = false;
+};
+
+#endif
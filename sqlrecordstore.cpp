@@ -0,0 +1,296 @@
+#include "sqlrecordstore.h"
+#include "recordstore.h"
+#include "cloudsync.h"
+#include <QSqlError>
+#include <QStringList>
+#include <QFile>
+#include <QDebug>
+
+namespace {
+// 排序列只能来自这张表，不拼接任何外部字符串
+const char* orderColumn(RecordQuery::Column column) {
+    switch (column) {
+        case RecordQuery::Score: return "score";
+        case RecordQuery::Time: return "time";
+        case RecordQuery::Player: return "player";
+        case RecordQuery::Difficulty: return "difficulty";
+        case RecordQuery::DateTime: return "dateTime";
+    }
+    return "score";
+}
+
+const char* SELECT_COLUMNS = "SELECT id, score, time, player, difficulty, dateTime FROM records";
+}
+
+SqlRecordStore::SqlRecordStore(const QString& basePath)
+    : basePath(basePath), connectionName("records-" + basePath), insertQuery(nullptr),
+      insertThread(nullptr), total(0), maxId(0)
+{
+}
+
+SqlRecordStore::~SqlRecordStore() {
+    delete insertQuery;
+    for (const QString& name : connections) {
+        QSqlDatabase::database(name, false).close();
+        QSqlDatabase::removeDatabase(name);
+    }
+}
+
+QSqlDatabase SqlRecordStore::database() {
+    QString name = connectionName + "-" + QString::number(quintptr(QThread::currentThread()), 16);
+    if (!connections.contains(name)) {
+        // 复制主连接的设置，在当前线程打开
+        QSqlDatabase db = QSqlDatabase::cloneDatabase(connectionName, name);
+        if (!db.open()) {
+            qDebug() << "Cannot open records connection" << db.lastError().text();
+        }
+        connections.append(name);
+    }
+    return QSqlDatabase::database(name, false);
+}
+
+QSqlDatabase SqlRecordStore::database() const {
+    return const_cast<SqlRecordStore*>(this)->database();
+}
+
+bool SqlRecordStore::open() {
+    QString path = basePath + ".sqlite";
+    bool fresh = !QFile::exists(path);
+
+    // 主连接只保存设置，不直接使用
+    QSqlDatabase::addDatabase("QSQLITE", connectionName).setDatabaseName(path);
+    QSqlDatabase db = database();
+    if (!db.isOpen()) return false;
+
+    QSqlQuery pragma(db);
+    pragma.exec("PRAGMA journal_mode=WAL");
+    pragma.exec("PRAGMA synchronous=NORMAL"); // WAL下每次提交不再等待fsync
+    if (!createSchema()) return false;
+
+    if (fresh && QFile::exists(basePath + ".dat")) {
+        importLog();
+    }
+
+    QSqlQuery stat(db);
+    if (stat.exec("SELECT COUNT(*), COALESCE(MAX(id), 0) FROM records") && stat.next()) {
+        total = stat.value(0).toInt();
+        maxId = stat.value(1).toLongLong();
+    }
+    return true;
+}
+
+bool SqlRecordStore::createSchema() {
+    const char* statements[] = {
+        "CREATE TABLE IF NOT EXISTS records ("
+        "id INTEGER PRIMARY KEY, score INTEGER NOT NULL, time INTEGER NOT NULL, "
+        "player TEXT NOT NULL, difficulty TEXT NOT NULL, difficultyCode INTEGER NOT NULL, "
+        "dateTime TEXT NOT NULL)",
+        "CREATE INDEX IF NOT EXISTS idx_records_difficulty_score ON records (difficultyCode, score DESC)",
+        "CREATE INDEX IF NOT EXISTS idx_records_player ON records (player)",
+        "CREATE INDEX IF NOT EXISTS idx_records_datetime ON records (dateTime)",
+    };
+    QSqlQuery q(database());
+    for (const char* sql : statements) {
+        if (!q.exec(sql)) {
+            qDebug() << "Cannot create records schema" << q.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SqlRecordStore::prepareInsert() {
+    if (insertQuery && insertThread == QThread::currentThread()) return true;
+    delete insertQuery;
+    insertQuery = new QSqlQuery(database());
+    insertThread = QThread::currentThread();
+    return insertQuery->prepare("INSERT INTO records (score, time, player, difficulty, difficultyCode, dateTime) "
+                                "VALUES (?, ?, ?, ?, ?, ?)");
+}
+
+bool SqlRecordStore::importLog() {
+    // 从二进制日志按写入顺序导入，日志序号直接作为id，之后新增的记录接着编号
+    RecordStore old(basePath);
+    if (!old.open()) return false;
+    QSqlDatabase db = database();
+    QSqlQuery q(db);
+    if (!q.prepare("INSERT INTO records (id, score, time, player, difficulty, difficultyCode, dateTime) "
+                   "VALUES (?, ?, ?, ?, ?, ?, ?)")) return false;
+    quint64 offset = 0;
+    int imported = 0;
+    db.transaction();
+    while (true) {
+        QVector<Record> rs;
+        QVector<quint32> seqs;
+        quint64 next;
+        if (old.readFrom(offset, 500, rs, seqs, next) == 0) break;
+        for (int i = 0; i < rs.size(); i++) {
+            const Record& r = rs[i];
+            q.addBindValue(qint64(seqs[i]));
+            q.addBindValue(r.score);
+            q.addBindValue(r.time);
+            q.addBindValue(r.playerName);
+            q.addBindValue(r.difficulty);
+            q.addBindValue(difficultyCode(r.difficulty));
+            q.addBindValue(r.dateTime);
+            if (!q.exec()) {
+                qDebug() << "Import record failed" << q.lastError().text();
+                db.rollback();
+                return false;
+            }
+        }
+        imported += rs.size();
+        offset = next;
+    }
+    if (!db.commit()) return false;
+
+    // 旧日志已转入上传队列的部分不再重复上传：把日志偏移换成第一条未入队记录的id，
+    // 设备ID原样保留，服务器仍能按(deviceId, clientSeq)去重
+    quint64 enqueued = 0;
+    QString deviceId;
+    if (CloudSync::readState(old.name() + ".sync", enqueued, deviceId)) {
+        QVector<Record> rs;
+        QVector<quint32> seqs;
+        quint64 next;
+        quint64 cursor = old.readFrom(enqueued, 1, rs, seqs, next) == 1 ? seqs[0] : old.nextSequence();
+        CloudSync::writeState(name() + ".sync", cursor, deviceId);
+    }
+    qDebug() << "Imported" << imported << "records into SQLite";
+    return true;
+}
+
+bool SqlRecordStore::insert(const Record& r) {
+    insertQuery->addBindValue(r.score);
+    insertQuery->addBindValue(r.time);
+    insertQuery->addBindValue(r.playerName);
+    insertQuery->addBindValue(r.difficulty);
+    insertQuery->addBindValue(difficultyCode(r.difficulty));
+    insertQuery->addBindValue(r.dateTime);
+    if (!insertQuery->exec()) {
+        qDebug() << "Insert record failed" << insertQuery->lastError().text();
+        return false;
+    }
+    total++;
+    maxId = qMax(maxId, insertQuery->lastInsertId().toLongLong());
+    return true;
+}
+
+bool SqlRecordStore::append(const Record& r) {
+    if (!prepareInsert()) return false;
+    return insert(r);
+}
+
+bool SqlRecordStore::appendBatch(const QVector<Record>& rs) {
+    if (!prepareInsert()) return false;
+    QSqlDatabase db = database();
+    int oldTotal = total;
+    qint64 oldMaxId = maxId;
+    db.transaction();
+    for (const Record& r : rs) {
+        if (!insert(r)) {
+            db.rollback();
+            total = oldTotal;
+            maxId = oldMaxId;
+            return false;
+        }
+    }
+    return db.commit();
+}
+
+Record SqlRecordStore::fromQuery(const QSqlQuery& query) {
+    Record r;
+    r.score = query.value(1).toInt();
+    r.time = query.value(2).toInt();
+    r.playerName = query.value(3).toString();
+    r.difficulty = query.value(4).toString();
+    r.dateTime = query.value(5).toString();
+    r.id = -1;
+    return r;
+}
+
+QVector<Record> SqlRecordStore::top(int n, int difficultyCode) {
+    QSqlQuery q(database());
+    QString sql = SELECT_COLUMNS;
+    if (difficultyCode >= 0) sql += " WHERE difficultyCode = ?";
+    sql += " ORDER BY score DESC, id LIMIT ?";
+    q.prepare(sql);
+    if (difficultyCode >= 0) q.addBindValue(difficultyCode);
+    q.addBindValue(n); // SQLite中LIMIT -1表示不限
+    QVector<Record> rs;
+    if (!q.exec()) return rs;
+    while (q.next()) rs.append(fromQuery(q));
+    return rs;
+}
+
+QList<int> SqlRecordStore::difficultyCodes() const {
+    QList<int> codes;
+    QSqlQuery q("SELECT DISTINCT difficultyCode FROM records", database());
+    while (q.next()) codes.append(q.value(0).toInt());
+    return codes;
+}
+
+QVector<qint32> SqlRecordStore::scores(int difficultyCode) const {
+    // 只走(difficultyCode, score)索引，不读取行数据
+    QSqlQuery q(database());
+    q.prepare("SELECT score FROM records WHERE difficultyCode = ? ORDER BY score DESC");
+    q.addBindValue(difficultyCode);
+    QVector<qint32> rs;
+    if (!q.exec()) return rs;
+    while (q.next()) rs.append(q.value(0).toInt());
+    return rs;
+}
+
+QString SqlRecordStore::whereClause(const RecordQuery& q) const {
+    QStringList conditions;
+    if (!q.difficulty.isEmpty()) conditions << "difficultyCode = ?";
+    if (!q.player.isEmpty()) conditions << "player = ?";
+    return conditions.isEmpty() ? QString() : " WHERE " + conditions.join(" AND ");
+}
+
+void SqlRecordStore::bindFilter(QSqlQuery& query, const RecordQuery& q) const {
+    if (!q.difficulty.isEmpty()) query.addBindValue(difficultyCode(q.difficulty));
+    if (!q.player.isEmpty()) query.addBindValue(q.player);
+}
+
+int SqlRecordStore::queryCount(const RecordQuery& q) {
+    QSqlQuery query(database());
+    query.prepare("SELECT COUNT(*) FROM records" + whereClause(q));
+    bindFilter(query, q);
+    if (!query.exec() || !query.next()) return 0;
+    return query.value(0).toInt();
+}
+
+QVector<Record> SqlRecordStore::query(const RecordQuery& q, int offset, int limit) {
+    QSqlQuery query(database());
+    query.prepare(QString(SELECT_COLUMNS) + whereClause(q)
+                  + QString(" ORDER BY %1 %2, id LIMIT ? OFFSET ?")
+                        .arg(orderColumn(q.sortColumn), q.descending ? "DESC" : "ASC"));
+    bindFilter(query, q);
+    query.addBindValue(limit);
+    query.addBindValue(offset);
+    QVector<Record> rs;
+    if (!query.exec()) {
+        qDebug() << "Record query failed" << query.lastError().text();
+        return rs;
+    }
+    while (query.next()) rs.append(fromQuery(query));
+    return rs;
+}
+
+int SqlRecordStore::readFrom(quint64 offset, int max, QVector<Record>& out, QVector<quint32>& seqs, quint64& next) {
+    next = offset;
+    QSqlQuery q(database());
+    q.prepare(QString(SELECT_COLUMNS) + " WHERE id >= ? ORDER BY id LIMIT ?");
+    q.addBindValue(qint64(offset));
+    q.addBindValue(max);
+    if (!q.exec()) return 0;
+    int n = 0;
+    while (q.next()) {
+        qint64 id = q.value(0).toLongLong();
+        out.append(fromQuery(q));
+        seqs.append(quint32(id));
+        next = quint64(id) + 1;
+        n++;
+    }
+    return n;
+}
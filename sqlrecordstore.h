@@ -0,0 +1,53 @@
+#ifndef SQLRECORDSTORE_H
+#define SQLRECORDSTORE_H
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include "recordstorage.h"
+
+// SQLite记录存储（可选后端）。WAL模式，(difficultyCode, score)、player、dateTime上建有索引，
+// 过滤、排序和分页都交给数据库完成，读取位置游标为行号id。从二进制日志导入的记录沿用日志序号作为id，
+// 上传时的clientSeq保持不变。
+// QSqlDatabase连接不能跨线程使用，每个访问线程各自打开一个连接（WAL下读写互不阻塞），
+// 调用方仍需保证同一时刻只有一个线程调用本对象。
+class SqlRecordStore : public RecordStorage {
+public:
+    explicit SqlRecordStore(const QString& basePath = "records");
+    ~SqlRecordStore();
+
+    bool open() override; // 首次创建数据库时导入records.dat中的记录
+    QString name() const override { return basePath + "-sqlite"; }
+    bool append(const Record& r) override;
+    bool appendBatch(const QVector<Record>& rs) override; // 一个事务内批量插入
+    int count() const override { return total; }
+    QVector<Record> top(int n, int difficultyCode = -1) override;
+    QList<int> difficultyCodes() const override;
+    QVector<qint32> scores(int difficultyCode) const override;
+    int queryCount(const RecordQuery& q) override;
+    QVector<Record> query(const RecordQuery& q, int offset, int limit) override;
+    quint64 endOffset() const override { return quint64(maxId) + 1; }
+    int readFrom(quint64 offset, int max, QVector<Record>& out, QVector<quint32>& seqs, quint64& next) override;
+
+private:
+    QString basePath;
+    QString connectionName;
+    QStringList connections; // 已为各线程打开的连接名
+    QSqlQuery *insertQuery;  // 预编译的插入语句，属于insertThread的连接
+    QThread *insertThread;
+    int total;
+    qint64 maxId;
+
+    QSqlDatabase database();            // 当前线程的连接，首次使用时打开
+    QSqlDatabase database() const;
+    bool prepareInsert();
+    bool createSchema();
+    bool insert(const Record& r);
+    bool importLog();
+    QString whereClause(const RecordQuery& q) const;
+    void bindFilter(QSqlQuery& query, const RecordQuery& q) const;
+    static Record fromQuery(const QSqlQuery& query);
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "startuptrace.h"
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QVector>
+#include <QThread>
+#include <QFile>
+#include <QDebug>
+
+namespace {
+struct TraceEvent {
+    QString name;
+    qint64 startUs;
+    qint64 durUs;
+    quint64 tid;
+    QJsonObject args;
+};
+
+QMutex traceMutex; // 媒体文件查找等阶段在线程池上运行
+QVector<TraceEvent> traceEvents;
+bool traceFinished = false;
+
+QElapsedTimer& clock() {
+    static QElapsedTimer timer = []() {
+        QElapsedTimer t;
+        t.start();
+        return t;
+    }();
+    return timer;
+}
+}
+
+bool StartupTrace::enabled() {
+    static const bool on = !qEnvironmentVariableIsEmpty("LLK_STARTUP_TRACE");
+    return on;
+}
+
+qint64 StartupTrace::nowUs() {
+    return clock().nsecsElapsed() / 1000;
+}
+
+StartupTrace::Scope::Scope(const char* name) : name(name), startUs(enabled() ? nowUs() : 0) {
+}
+
+StartupTrace::Scope::~Scope() {
+    if (enabled()) record(name, startUs, nowUs(), args);
+}
+
+void StartupTrace::record(const char* name, qint64 startUs, qint64 endUs, const QJsonObject& args) {
+    if (!enabled()) return;
+    QMutexLocker locker(&traceMutex);
+    if (traceFinished) return;
+    traceEvents.append({QString::fromUtf8(name), startUs, endUs - startUs,
+                        quint64(quintptr(QThread::currentThreadId())), args});
+}
+
+void StartupTrace::finish() {
+    if (!enabled()) return;
+    qint64 endUs = nowUs();
+    QMutexLocker locker(&traceMutex);
+    if (traceFinished) return;
+    traceFinished = true;
+
+    qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+    QStringList parts;
+    for (const TraceEvent& e : traceEvents) {
+        QJsonObject obj;
+        obj["name"] = e.name;
+        obj["cat"] = "startup";
+        obj["ph"] = "X";
+        obj["ts"] = e.startUs;
+        obj["dur"] = e.durUs;
+        obj["pid"] = pid;
+        obj["tid"] = qint64(e.tid);
+        if (!e.args.isEmpty()) obj["args"] = e.args;
+        events.append(obj);
+        parts << QString("%1 %2ms").arg(e.name).arg(e.durUs / 1000.0, 0, 'f', 1);
+    }
+    QJsonObject root;
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+
+    QString path = qEnvironmentVariable("LLK_STARTUP_TRACE");
+    QFile f(path);
+    if (f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        f.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+        f.close();
+    } else {
+        qDebug() << "Cannot write startup trace" << path;
+    }
+
+    QString summary = QString("Startup %1ms: %2").arg(endUs / 1000.0, 0, 'f', 1).arg(parts.join(", "));
+    bool ok = false;
+    int budgetMs = qEnvironmentVariableIntValue("LLK_STARTUP_BUDGET_MS", &ok);
+    if (ok && endUs / 1000 > budgetMs) {
+        summary += QString(" [OVER BUDGET %1ms]").arg(budgetMs);
+    }
+    qDebug().noquote() << summary;
+}
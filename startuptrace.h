@@ -0,0 +1,30 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+#include <QString>
+#include <QJsonObject>
+#include <QElapsedTimer>
+
+// 启动阶段计时。设置环境变量LLK_STARTUP_TRACE=<文件>时记录各阶段的单调时间戳，
+// 启动完成后写出Chrome trace格式（chrome://tracing、Perfetto可打开）的JSON，并在日志中输出一行汇总；
+// 设置LLK_STARTUP_BUDGET_MS时，超出预算会在汇总中标出。未设置时各调用几乎没有开销。
+class StartupTrace {
+public:
+    // 作用域计时：构造时开始，析构时记录一个阶段
+    class Scope {
+    public:
+        explicit Scope(const char* name);
+        ~Scope();
+        void setArg(const QString& key, int value) { args.insert(key, value); }
+    private:
+        const char* name;
+        qint64 startUs;
+        QJsonObject args;
+    };
+
+    static bool enabled();
+    static void record(const char* name, qint64 startUs, qint64 endUs, const QJsonObject& args = QJsonObject());
+    static qint64 nowUs(); // 自首次调用起的微秒数，单调递增
+    static void finish(); // 启动完成（窗口已显示）时调用一次，写出文件与汇总
+};
+
+#endif
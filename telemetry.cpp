@@ -0,0 +1,165 @@
+#include "telemetry.h"
+#include <QThread>
+#include <QMutex>
+#include <QFile>
+#include <QVector>
+#include <QStringList>
+#include <QDebug>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+const bool Telemetry::on = !qEnvironmentVariableIsEmpty("LLK_TELEMETRY");
+
+namespace {
+const char* const METRIC_NAMES[Telemetry::METRIC_COUNT] = {
+    "generate", "solverNodes", "hintLatency", "stuckCheck", "paint", "recordIO"
+};
+const int RING_SIZE = 4096; // 2的幂
+const int FLUSH_INTERVAL_MS = 200;
+const int BUCKETS = 64;
+
+struct Event {
+    qint64 timeUs;
+    qint64 value;
+    qint64 arg;
+    int metric;
+};
+
+// 单生产者（所属线程）单消费者（刷新线程）环形缓冲
+struct Ring {
+    Event events[RING_SIZE];
+    std::atomic<quint32> head{0}; // 生产者写入位置
+    std::atomic<quint32> tail{0}; // 消费者读取位置
+    std::atomic<quint64> dropped{0};
+    int threadIndex = 0;
+};
+
+// 直方图：第k个桶统计[2^(k-1), 2^k)的值
+struct Histogram {
+    qint64 count = 0;
+    qint64 sum = 0;
+    qint64 max = 0;
+    qint64 buckets[BUCKETS] = {};
+
+    void add(qint64 v) {
+        count++;
+        sum += v;
+        max = qMax(max, v);
+        int k = v > 0 ? 64 - qCountLeadingZeroBits(quint64(v)) : 0;
+        buckets[qMin(k, BUCKETS - 1)]++;
+    }
+    // 所在桶的上界，近似分位数
+    qint64 percentile(double p) const {
+        qint64 target = qint64(count * p);
+        qint64 seen = 0;
+        for (int k = 0; k < BUCKETS; k++) {
+            seen += buckets[k];
+            if (seen > target) return k == 0 ? 0 : qMin(max, (qint64(1) << k) - 1);
+        }
+        return max;
+    }
+};
+
+// 以下只在注册（每线程一次）和刷新时使用，由mutex保护
+QMutex registryMutex;
+QVector<std::shared_ptr<Ring>> rings;
+QThread* flusher = nullptr;
+std::atomic<bool> stopping{false};
+QFile output;
+Histogram histograms[Telemetry::METRIC_COUNT];
+
+qint64 drain() {
+    QByteArray lines;
+    qint64 dropped = 0;
+    for (const std::shared_ptr<Ring>& ring : rings) {
+        quint32 tail = ring->tail.load(std::memory_order_relaxed);
+        quint32 head = ring->head.load(std::memory_order_acquire);
+        for (; tail != head; tail++) {
+            const Event& e = ring->events[tail & (RING_SIZE - 1)];
+            histograms[e.metric].add(e.value);
+            lines += QString("{\"t\":%1,\"m\":\"%2\",\"v\":%3,\"a\":%4,\"th\":%5}\n")
+                     .arg(e.timeUs).arg(METRIC_NAMES[e.metric]).arg(e.value).arg(e.arg).arg(ring->threadIndex)
+                     .toUtf8();
+        }
+        ring->tail.store(tail, std::memory_order_release);
+        dropped += ring->dropped.load(std::memory_order_relaxed);
+    }
+    if (!lines.isEmpty() && output.isOpen()) {
+        output.write(lines);
+        output.flush();
+    }
+    return dropped;
+}
+
+// 调用线程第一次记录时注册自己的缓冲，并在需要时启动刷新线程
+Ring* threadRing() {
+    thread_local std::shared_ptr<Ring> ring;
+    if (ring) return ring.get();
+    ring = std::make_shared<Ring>();
+    QMutexLocker locker(&registryMutex);
+    if (stopping.load()) return nullptr;
+    ring->threadIndex = rings.size();
+    rings.append(ring); // 线程退出后缓冲仍由rings持有，剩余事件照常取出
+    if (!flusher) {
+        output.setFileName(qEnvironmentVariable("LLK_TELEMETRY"));
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            qDebug() << "Cannot open telemetry log" << output.fileName();
+        }
+        flusher = QThread::create([]() {
+            while (!stopping.load()) {
+                QThread::msleep(FLUSH_INTERVAL_MS);
+                QMutexLocker locker(&registryMutex);
+                drain();
+            }
+        });
+        flusher->setObjectName("Telemetry");
+        flusher->start(QThread::LowPriority);
+    }
+    return ring.get();
+}
+}
+
+qint64 Telemetry::nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Telemetry::record(Metric metric, qint64 value, qint64 arg) {
+    if (!on) return;
+    Ring* ring = threadRing();
+    if (!ring) return;
+    quint32 head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= quint32(RING_SIZE)) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring->events[head & (RING_SIZE - 1)] = {nowUs(), value, arg, metric};
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void Telemetry::shutdown() {
+    if (!on) return;
+    QThread* thread;
+    {
+        QMutexLocker locker(&registryMutex);
+        if (stopping.exchange(true)) return;
+        thread = flusher;
+    }
+    if (thread) {
+        thread->wait();
+        delete thread;
+    }
+    QMutexLocker locker(&registryMutex);
+    qint64 dropped = drain();
+    output.close();
+
+    for (int m = 0; m < METRIC_COUNT; m++) {
+        const Histogram& h = histograms[m];
+        if (h.count == 0) continue;
+        qDebug().noquote() << QString("Telemetry %1: n=%2 mean=%3 p50<=%4 p90<=%5 p99<=%6 max=%7")
+                              .arg(METRIC_NAMES[m]).arg(h.count).arg(double(h.sum) / h.count, 0, 'f', 1)
+                              .arg(h.percentile(0.5)).arg(h.percentile(0.9)).arg(h.percentile(0.99)).arg(h.max);
+    }
+    if (dropped > 0) qDebug() << "Telemetry dropped" << dropped << "events (ring buffer full)";
+}
@@ -0,0 +1,41 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+#include <QtGlobal>
+
+// 性能遥测。设置环境变量LLK_TELEMETRY=<文件>时启用：热路径上的事件写入每个线程自己的无锁环形缓冲，
+// 后台线程定期取出，追加为JSON Lines，并累计到按2的幂分桶的直方图；退出时在日志中输出各指标的汇总。
+// 未启用时每次调用只检查一个静态标志。缓冲满时丢弃新事件并计数，不阻塞调用线程。
+class Telemetry {
+public:
+    enum Metric {
+        GENERATE,     // 生成布局，值为耗时(us)，参数为验证重试次数
+        SOLVER_NODES, // 一次查找提示检查的格子对数，参数为找到的对数
+        HINT_LATENCY, // 从请求提示到得到结果(us)，参数为1表示命中缓存
+        STUCK_CHECK,  // 从请求僵局检测到得到结果(us)，参数为1表示僵局
+        PAINT,        // 绘制连线(us)
+        RECORD_IO,    // 记录批量写入(us)，参数为条数
+        METRIC_COUNT
+    };
+
+    // 作用域计时：析构时记录耗时
+    class Scope {
+    public:
+        explicit Scope(Metric metric) : metric(metric), arg(0), startUs(enabled() ? nowUs() : 0) {}
+        ~Scope() { if (startUs) record(metric, nowUs() - startUs, arg); }
+        void setArg(qint64 value) { arg = value; }
+    private:
+        Metric metric;
+        qint64 arg;
+        qint64 startUs;
+    };
+
+    static bool enabled() { return on; }
+    static qint64 nowUs(); // 单调时钟
+    static void record(Metric metric, qint64 value, qint64 arg = 0);
+    static void shutdown(); // 退出时调用：取出剩余事件、关闭文件并输出汇总
+
+private:
+    static const bool on;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "tileset.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QImageReader>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QPainter>
+#include <QFont>
+#include <QDebug>
+
+bool TileSet::loadManifest(const QString& manifestPath) {
+    QFile f(manifestPath);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    QJsonObject m = QJsonDocument::fromJson(f.readAll()).object();
+    QString imagePath = QFileInfo(manifestPath).dir().filePath(m.value("image").toString());
+
+    QImageReader reader(imagePath);
+    QImage image = reader.read();
+    if (image.isNull()) {
+        qDebug() << "Cannot decode tile sheet" << imagePath << reader.errorString();
+        return false;
+    }
+
+    QVector<QRect> slices;
+    const QJsonArray explicitTiles = m.value("tiles").toArray();
+    if (!explicitTiles.isEmpty()) {
+        for (const QJsonValue& v : explicitTiles) {
+            QJsonArray r = v.toArray();
+            slices.append(QRect(r.at(0).toInt(), r.at(1).toInt(), r.at(2).toInt(), r.at(3).toInt()));
+        }
+    } else {
+        int w = m.value("tileWidth").toInt();
+        int h = m.value("tileHeight").toInt(w);
+        int margin = m.value("margin").toInt(0);
+        int spacing = m.value("spacing").toInt(0);
+        if (w <= 0 || h <= 0) return false;
+        int columns = m.value("columns").toInt((image.width() - 2 * margin + spacing) / (w + spacing));
+        int rowsInSheet = (image.height() - 2 * margin + spacing) / (h + spacing);
+        int n = m.value("count").toInt(columns * rowsInSheet);
+        if (columns <= 0) return false;
+        for (int k = 0; k < n; k++) {
+            slices.append(QRect(margin + (k % columns) * (w + spacing), margin + (k / columns) * (h + spacing), w, h));
+        }
+    }
+    // 超出图片范围的矩形视为清单错误
+    for (const QRect& r : slices) {
+        if (!image.rect().contains(r)) {
+            qDebug() << "Tile" << r << "lies outside sheet" << image.size();
+            return false;
+        }
+    }
+
+    sheet = image;
+    rects = slices;
+    images.clear();
+    cache.clear();
+    qDebug() << "Loaded tile sheet" << imagePath << "with" << rects.size() << "tiles";
+    return true;
+}
+
+void TileSet::setImages(const QVector<QPixmap>& list) {
+    images = list;
+    sheet = QImage();
+    rects.clear();
+    cache.clear();
+}
+
+QPixmap TileSet::tile(int value) const {
+    if (value <= 0) return QPixmap();
+    auto it = cache.constFind(value);
+    if (it != cache.constEnd()) return *it;
+
+    QPixmap pix;
+    if (value <= rects.size()) {
+        // 只在用到时切出并缩放，copy()只复制这一块像素
+        QImage slice = sheet.copy(rects[value - 1]).scaled(tileSize, tileSize, Qt::KeepAspectRatio,
+                                                           Qt::SmoothTransformation);
+        pix = QPixmap::fromImage(slice);
+    } else if (rects.isEmpty() && value <= images.size()) {
+        pix = images[value - 1].scaled(tileSize, tileSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    } else {
+        pix = placeholder(value, tileSize);
+    }
+    cache.insert(value, pix);
+    return pix;
+}
+
+// 按值旋转色相，任意多种图案都能区分
+QPixmap TileSet::placeholder(int value, int size) {
+    QPixmap pix(size, size);
+    pix.fill(QColor::fromHsv((value * 47) % 360, 110 + (value / 360) % 3 * 50, 255));
+    QPainter painter(&pix);
+    painter.setPen(Qt::black);
+    painter.setFont(QFont("Arial", value < 100 ? 20 : 14, QFont::Bold));
+    painter.drawText(pix.rect(), Qt::AlignCenter, QString::number(value));
+    return pix;
+}
@@ -0,0 +1,33 @@
+#ifndef TILESET_H
+#define TILESET_H
+#include <QImage>
+#include <QPixmap>
+#include <QVector>
+#include <QRect>
+#include <QHash>
+
+// 图块图集：一张精灵图加一个JSON清单，整张图只解码一次，按子矩形切出各图块。
+// 清单示例（tiles可省略，按网格从左到右、从上到下排列）：
+//   {"image": "tiles.png", "tileWidth": 64, "tileHeight": 64, "columns": 16, "count": 300,
+//    "margin": 0, "spacing": 0, "tiles": [[x, y, w, h], ...]}
+// 也可以直接给出逐张的图片（旧的1.jpg~8.jpg）。超出图集范围的图案值画成带编号的色块。
+class TileSet {
+public:
+    explicit TileSet(int tileSize = 50) : tileSize(tileSize) {}
+
+    bool loadManifest(const QString& manifestPath);
+    void setImages(const QVector<QPixmap>& images); // 逐张图片，images[0]对应图案1
+    int count() const { return rects.isEmpty() ? images.size() : rects.size(); }
+    QPixmap tile(int value) const; // value从1开始；缩放后的结果按值缓存
+
+    static QPixmap placeholder(int value, int size);
+
+private:
+    int tileSize;
+    QImage sheet;
+    QVector<QRect> rects;
+    QVector<QPixmap> images;
+    mutable QHash<int, QPixmap> cache;
+};
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef VARINT_H
+#define VARINT_H
+#include <QByteArray>
+
+// 无符号LEB128变长整数：每字节7位，最高位表示后面还有字节。回放日志与观战数据共用
+inline void putVarint(QByteArray& out, quint64 v) {
+    while (v >= 0x80) {
+        out.append(char(quint8(v) | 0x80));
+        v >>= 7;
+    }
+    out.append(char(v));
+}
+
+inline bool getVarint(const QByteArray& in, int& pos, quint64& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= in.size()) return false;
+        quint8 byte = quint8(in[pos++]);
+        v |= quint64(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+#endif